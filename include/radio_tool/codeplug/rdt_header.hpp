@@ -17,10 +17,13 @@
  */
 #pragma once
 
+#include <radio_tool/util/perfect_hash.hpp>
+
 #include <vector>
 #include <fstream>
 #include <string>
 #include <tuple>
+#include <string_view>
 
 #include <cstring>
 #include <stdint.h>
@@ -29,13 +32,42 @@ using namespace std::literals::string_literals;
 
 namespace radio_tool::codeplug
 {
-    const std::vector<std::tuple<std::string, uint32_t, uint32_t>> RadioConfigs = {
+    struct RDTRadioConfig
+    {
+        const char *radio;
+        uint32_t timestamp_offset;
+        uint32_t general_offset;
+    };
+
+    constexpr RDTRadioConfig RadioConfigs[] = {
         /* Radio, Timestamp, General */
-        { "DM-1701"s, 0x2001u, 0x2040u },
-        { "2017"s, 0x2001u, 0x2040u },
-        { "DR780"s, 0x2001u, 0x2040u }
+        { "DM-1701", 0x2001u, 0x2040u },
+        { "2017", 0x2001u, 0x2040u },
+        { "DR780", 0x2001u, 0x2040u }
     };
 
+    constexpr auto RadioConfigCount = sizeof(RadioConfigs) / sizeof(RadioConfigs[0]);
+
+    /**
+     * Perfect hash of RadioConfigs by radio name
+     */
+    constexpr hash::PerfectHash<RadioConfigCount> RadioConfigIndex([]() constexpr {
+        std::array<uint32_t, RadioConfigCount> ret{};
+        for (size_t x = 0; x < RadioConfigCount; x++)
+            ret[x] = hash::FNV1a(RadioConfigs[x].radio);
+        return ret;
+    }());
+
+    /**
+     * Find the config for a radio
+     * @returns nullptr if the radio is not known
+     */
+    constexpr auto FindRadioConfig(const std::string_view &radio) -> const RDTRadioConfig *
+    {
+        auto idx = RadioConfigIndex.Find(hash::FNV1a(radio));
+        return idx < 0 || radio != RadioConfigs[idx].radio ? nullptr : &RadioConfigs[idx];
+    }
+
     enum class RDTType : uint8_t
     {
         Unknown = 0,
@@ -90,32 +122,14 @@ namespace radio_tool::codeplug
 
         auto GetTimestampOffset() const -> const uint32_t
         {
-            for(const auto& rx : RadioConfigs)
-            {
-                auto r = std::get<0>(rx);
-                auto o = std::get<1>(rx);
-
-                if(r == radio)
-                {
-                    return o;
-                }
-            }
-            return 0x2001u; //default
+            auto rx = FindRadioConfig(radio);
+            return rx == nullptr ? 0x2001u /* default */ : rx->timestamp_offset;
         }
         
         auto GetGeneralOffset() const -> const uint32_t
         {
-            for(const auto& rx : RadioConfigs)
-            {
-                auto r = std::get<0>(rx);
-                auto o = std::get<2>(rx);
-
-                if(r == radio)
-                {
-                    return o;
-                }
-            }
-            return 0x2040u; //default
+            auto rx = FindRadioConfig(radio);
+            return rx == nullptr ? 0x2040u /* default */ : rx->general_offset;
         }
 
         RDTType type;
@@ -247,6 +247,11 @@ namespace radio_tool::dfu
         auto Abort() const -> void;
         auto Detach() const -> void;
 
+        /**
+         * USB serial number (iSerialNumber) of the device, empty if it has none
+         */
+        auto GetSerialNumber() const -> std::string;
+
     private:
         libusb_context *usb_ctx;
         auto GetDeviceString(const libusb_device_descriptor &, libusb_device_handle *) const -> std::wstring;
@@ -0,0 +1,171 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <radio_tool/fw/cipher/md380.hpp>
+#include <radio_tool/fw/cipher/md9600.hpp>
+#include <radio_tool/fw/cipher/uv3x0.hpp>
+#include <radio_tool/fw/cipher/dm1701.hpp>
+#include <radio_tool/fw/cipher/cs800.hpp>
+#include <radio_tool/fw/cipher/dr5xx0.hpp>
+#include <radio_tool/util/keystream.hpp>
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace radio_tool::fw::cipher
+{
+    /**
+     * All known XOR keys
+     */
+    enum class CipherKey : uint8_t
+    {
+        MD380,
+        MD9600,
+        UV3X0,
+        DM1701,
+        CS800_0,
+        CS800_1,
+        DR5XX0
+    };
+
+    /**
+     * Compile time info about a key
+     */
+    template <CipherKey C>
+    class CipherTraits;
+
+    template <>
+    class CipherTraits<CipherKey::MD380>
+    {
+    public:
+        static constexpr auto Name = "md380";
+        static constexpr auto Key = md380;
+        static constexpr uint32_t Length = md380_length;
+    };
+
+    template <>
+    class CipherTraits<CipherKey::MD9600>
+    {
+    public:
+        static constexpr auto Name = "md9600";
+        static constexpr auto Key = md9600;
+        static constexpr uint32_t Length = md9600_length;
+    };
+
+    template <>
+    class CipherTraits<CipherKey::UV3X0>
+    {
+    public:
+        static constexpr auto Name = "uv3x0";
+        static constexpr auto Key = uv3x0;
+        static constexpr uint32_t Length = uv3x0_length;
+    };
+
+    template <>
+    class CipherTraits<CipherKey::DM1701>
+    {
+    public:
+        static constexpr auto Name = "dm1701";
+        static constexpr auto Key = dm1701;
+        static constexpr uint32_t Length = dm1701_length;
+    };
+
+    template <>
+    class CipherTraits<CipherKey::CS800_0>
+    {
+    public:
+        static constexpr auto Name = "cs800_0";
+        static constexpr auto Key = cs800_0;
+        static constexpr uint32_t Length = cs800_length;
+    };
+
+    template <>
+    class CipherTraits<CipherKey::CS800_1>
+    {
+    public:
+        static constexpr auto Name = "cs800_1";
+        static constexpr auto Key = cs800_1;
+        static constexpr uint32_t Length = cs800_length;
+    };
+
+    template <>
+    class CipherTraits<CipherKey::DR5XX0>
+    {
+    public:
+        static constexpr auto Name = "dr5xx0";
+        static constexpr auto Key = dr5xx0;
+        static constexpr uint32_t Length = dr5xx0_length;
+    };
+
+    /**
+     * Create a keystream for a key known at compile time, using kernels specialized on its length
+     */
+    template <CipherKey C>
+    auto MakeCipherStream(const uint64_t &offset = 0) -> keystream::CipherStream
+    {
+        using T = CipherTraits<C>;
+        static_assert((T::Length & (T::Length - 1)) == 0, "Cipher length must be a power of two");
+        return keystream::CipherStream::Fixed<T::Length>(T::Key, offset);
+    }
+
+    /**
+     * Runtime info about a key
+     */
+    class CipherInfo
+    {
+    public:
+        CipherKey id;
+        const char *name;
+        const uint8_t *key;
+        uint32_t length;
+
+        /**
+         * Statically dispatched stream factory for this key
+         */
+        keystream::CipherStream (*make)(const uint64_t &offset);
+    };
+
+    template <CipherKey C>
+    constexpr auto MakeCipherInfo() -> CipherInfo
+    {
+        return {C, CipherTraits<C>::Name, CipherTraits<C>::Key, CipherTraits<C>::Length, &MakeCipherStream<C>};
+    }
+
+    /**
+     * All keys, indexed by CipherKey
+     */
+    constexpr CipherInfo AllCiphers[] = {
+        MakeCipherInfo<CipherKey::MD380>(),
+        MakeCipherInfo<CipherKey::MD9600>(),
+        MakeCipherInfo<CipherKey::UV3X0>(),
+        MakeCipherInfo<CipherKey::DM1701>(),
+        MakeCipherInfo<CipherKey::CS800_0>(),
+        MakeCipherInfo<CipherKey::CS800_1>(),
+        MakeCipherInfo<CipherKey::DR5XX0>()};
+
+    /**
+     * Lookup a key at runtime
+     */
+    constexpr auto GetCipherInfo(const CipherKey &c) -> const CipherInfo &
+    {
+        return AllCiphers[static_cast<size_t>(c)];
+    }
+
+    static_assert(GetCipherInfo(CipherKey::DR5XX0).id == CipherKey::DR5XX0, "AllCiphers must be in CipherKey order");
+} // namespace radio_tool::fw::cipher
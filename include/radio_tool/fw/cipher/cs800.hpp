@@ -28,7 +28,7 @@ namespace radio_tool::fw::cipher
      * Connect Systems CS800 (Key=0x00)
      * https://github.com/KG5RKI/CSFWTOOL
      */
-    const unsigned char cs800_0[cs800_length] = {
+    inline constexpr unsigned char cs800_0[cs800_length] = {
         0x60, 0x5e, 0x5d, 0x5c, 0x5a, 0x59, 0x36, 0x34, 0x33, 0x31, 0x30, 0x2e, 0x2d, 0x2b, 0x2a, 0x28, 
         0x6c, 0x6d, 0x6e, 0x6f, 0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x75, 0x76, 0x77, 0x78, 0x78, 0x79, 
         0x07, 0x08, 0x09, 0x09, 0x0a, 0x0b, 0x7a, 0x04, 0x05, 0x06, 0x06, 0x7a, 0x7b, 0x7b, 0x7c, 0x7c, 
@@ -51,7 +51,7 @@ namespace radio_tool::fw::cipher
      * Connect Systems CS800 (Key=0x01)
      * https://github.com/KG5RKI/CSFWTOOL
      */
-    const unsigned char cs800_1[cs800_length] = {
+    inline constexpr unsigned char cs800_1[cs800_length] = {
         0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x01, 0x02, 0x02, 0x03, 0x03, 0x04,
         0x04, 0x05, 0x06, 0x06, 0x07, 0x08, 0x09, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11,
         0x12, 0x13, 0x2e, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1c, 0x1d, 0x1e, 0x20, 0x21, 0x22, 0x24, 0x25,
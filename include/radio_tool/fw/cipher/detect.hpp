@@ -0,0 +1,122 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <radio_tool/fw/fw.hpp>
+#include <radio_tool/fw/cipher/cipher.hpp>
+
+#include <vector>
+#include <optional>
+#include <stdint.h>
+
+namespace radio_tool::fw::cipher
+{
+    /**
+     * What a sample of encrypted data is expected to decrypt to
+     */
+    enum class SampleType : uint8_t
+    {
+        /**
+         * Start of a segment, should be a Cortex-M vector table
+         */
+        VectorTable,
+
+        /**
+         * End of a segment, usually padded with 0xFF/0x00
+         */
+        Padding
+    };
+
+    /**
+     * A small piece of encrypted firmware used to score keys
+     */
+    class DetectSample
+    {
+    public:
+        SampleType type;
+
+        /**
+         * Position in the key of the first byte of data
+         */
+        uint32_t key_offset;
+        std::vector<uint8_t> data;
+    };
+
+    /**
+     * Result of scoring a key against samples
+     */
+    class DetectResult
+    {
+    public:
+        const CipherInfo *cipher;
+
+        /**
+         * Score (0-1) of the decrypted samples
+         */
+        double score;
+
+        /**
+         * Share (0-1) of the total score of all candidates
+         */
+        double confidence;
+    };
+
+    /**
+     * Detects which known key encrypted a firmware image
+     */
+    class CipherDetect
+    {
+    public:
+        /**
+         * Minimum score and confidence for Detect to return a key
+         */
+        static constexpr double MinScore = 0.5;
+        static constexpr double MinConfidence = 0.5;
+
+        /**
+         * Number of bytes sampled from the end of a segment
+         */
+        static constexpr uint32_t PaddingSampleSize = 0x1000;
+
+        /**
+         * Make samples from the start and end of a segment
+         * @param key_offset Position in the key of the first byte of the segment
+         */
+        static auto MakeSamples(const uint8_t *data, const size_t &len, const uint32_t &key_offset = 0) -> std::vector<DetectSample>;
+
+        /**
+         * Make samples from every segment of a firmware file
+         */
+        static auto MakeSamples(const FirmwareSupport &fw) -> std::vector<DetectSample>;
+
+        /**
+         * Score each candidate key against the samples, best first
+         * @param candidates Keys to test, all known keys if empty
+         * @note Only the samples are decrypted, candidates are scored in parallel
+         */
+        static auto Rank(const std::vector<DetectSample> &samples, const std::vector<CipherKey> &candidates = {}) -> std::vector<DetectResult>;
+
+        /**
+         * Best key for the samples, if any key scores well enough
+         */
+        static auto Detect(const std::vector<DetectSample> &samples, const std::vector<CipherKey> &candidates = {}) -> std::optional<DetectResult>;
+
+    private:
+        static auto Score(const std::vector<DetectSample> &samples, const CipherInfo &cipher) -> double;
+    };
+} // namespace radio_tool::fw::cipher
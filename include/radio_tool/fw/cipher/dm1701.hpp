@@ -24,7 +24,7 @@ namespace radio_tool::fw::cipher
     /**
      * Thanks to KG5RKI for the help
      */
-    const unsigned char dm1701[dm1701_length] = {
+    inline constexpr unsigned char dm1701[dm1701_length] = {
         0x3a, 0x04, 0x74, 0xad, 0x90, 0xae, 0xb3, 0x78, 0xde, 0xfa, 0x73, 0x8d, 0xdc, 0x8c, 0x53, 0x67,
         0x27, 0x61, 0xf3, 0x6f, 0x95, 0xc8, 0xf1, 0x1f, 0xc5, 0xad, 0x17, 0x68, 0xfb, 0x1d, 0xd2, 0x51,
         0x2b, 0x07, 0xe6, 0xe2, 0x54, 0x40, 0x61, 0x40, 0x10, 0xca, 0xcd, 0x19, 0x68, 0x56, 0xaa, 0x42,
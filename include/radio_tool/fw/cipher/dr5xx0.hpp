@@ -28,7 +28,7 @@ namespace radio_tool::fw::cipher
      * Connect Systems DR5XX0
      * https://github.com/KG5RKI/CSFWTOOL
      */
-    const unsigned char dr5xx0[dr5xx0_length] = {
+    inline constexpr unsigned char dr5xx0[dr5xx0_length] = {
         0x3F, 0x41, 0x42, 0x44, 0x45, 0x47, 0x48, 0x4A, 0x4B, 0x4D, 0x4E, 0x50, 0x51, 0x53, 0x54, 0x56,
         0x57, 0x59, 0x5A, 0x5C, 0x5D, 0x5E, 0x60, 0x61, 0x62, 0x64, 0x65, 0x66, 0x67, 0x68, 0x6A, 0x6B,
         0x6C, 0x6D, 0x6E, 0x6F, 0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x75, 0x76, 0x77, 0x78, 0x78, 0x79,
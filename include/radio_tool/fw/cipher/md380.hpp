@@ -23,7 +23,7 @@ namespace radio_tool::fw::cipher
     /**
      * https://github.com/travisgoodspeed/md380tools/blob/master/md380_fw.py
      */
-    const unsigned char md380[md380_length] = {
+    inline constexpr unsigned char md380[md380_length] = {
         0x2e, 0xdf, 0x40, 0xb5, 0xbd, 0xda, 0x91, 0x35, 0x21, 0x42, 0xe3, 0xe2, 0x6d, 0xa9, 0x0b, 0x90,
         0x31, 0x30, 0x3a, 0xfa, 0x4f, 0x05, 0x74, 0x64, 0x0a, 0x29, 0x44, 0x7e, 0x60, 0x77, 0xad, 0x8c,
         0x9a, 0xe2, 0x63, 0xc4, 0x21, 0xfe, 0x3c, 0xf7, 0x93, 0xc2, 0xe1, 0x74, 0x16, 0x8c, 0xc9, 0x2a,
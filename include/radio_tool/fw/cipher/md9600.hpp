@@ -23,7 +23,7 @@ namespace radio_tool::fw::cipher
 
     //md9600 fw encryption key
     // -KG5RKI
-    const unsigned char md9600[md9600_length] = {
+    inline constexpr unsigned char md9600[md9600_length] = {
         0xa2, 0xfa, 0xbb, 0x4b, 0x90, 0x8f, 0x17, 0x20, 0x96, 0x36, 0x43, 0x84, 0xf7, 0xac, 0x4e, 0x55,
         0xea, 0xe5, 0xb4, 0x36, 0x55, 0xb9, 0x39, 0xe2, 0xd8, 0xda, 0x18, 0xc0, 0x0d, 0x09, 0x5d, 0xb8,
         0x0e, 0x89, 0x90, 0x46, 0x38, 0xd4, 0x93, 0xcc, 0x2f, 0x8e, 0xcd, 0x2d, 0x22, 0xb7, 0x89, 0x97,
@@ -21,7 +21,7 @@ namespace radio_tool::fw::cipher
 {
     constexpr auto uv3x0_length = 1024;
     
-    const unsigned char uv3x0[uv3x0_length] = {
+    inline constexpr unsigned char uv3x0[uv3x0_length] = {
         0x00, 0xaa, 0x89, 0x89, 0x1f, 0x4b, 0xec, 0xcf, 0x42, 0x45, 0x14, 0x54, 0x00, 0x65, 0xeb, 0x66, 
         0x41, 0x7d, 0x4c, 0x88, 0x49, 0x5a, 0x21, 0x0d, 0xf2, 0xf5, 0xc8, 0xe6, 0x38, 0xed, 0xbc, 0xb9,
         0xfb, 0x35, 0x71, 0x33, 0x01, 0x0a, 0x7f, 0x9e, 0x3b, 0x29, 0x03, 0xb6, 0x49, 0x3e, 0x42, 0xb8,
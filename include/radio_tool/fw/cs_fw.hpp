@@ -21,6 +21,8 @@
 #pragma once
 
 #include <radio_tool/fw/fw.hpp>
+#include <radio_tool/fw/cipher/cipher.hpp>
+#include <radio_tool/util/checksum.hpp>
 
 #include <memory>
 
@@ -48,17 +50,25 @@ namespace radio_tool::fw
     {
     public:
         auto Read(const std::string &fw) -> void override;
+        auto ReadHeader(const ByteView &header, const uint64_t &file_size) -> void override;
         auto Write(const std::string &fw) -> void override;
+        auto WriteSegments(const std::string &fw, const std::vector<std::pair<uint32_t, std::string>> &segments) -> void override;
         auto ToString() const -> std::string override;
         auto GetRadioModel() const -> const std::string override;
         auto SetRadioModel(const std::string&) -> void override;
         auto Decrypt() -> void override;
         auto Encrypt() -> void override;
+        auto GetCipher() const -> keystream::CipherStream override;
+
+        auto GetDataOffset() const -> uint64_t override
+        {
+            return sizeof(CS800D_header);
+        }
 
         /**
-         * Tests a file if its a valid firmware file
+         * Tests the start of a file if its a valid firmware file
          */
-        static auto SupportsFirmwareFile(const std::string &file) -> bool;
+        static auto SupportsFirmwareFile(const ByteView &header, const uint64_t &file_size) -> bool;
 
         static auto SupportsRadioModel(const std::string &model) -> bool;
 
@@ -73,8 +83,26 @@ namespace radio_tool::fw
         CS800D_header header;
         uint16_t checksum;
 
-        auto MakeChecksum() const -> const uint16_t;
-        auto MakeFiledata() const -> std::vector<uint8_t>;
+        /**
+         * Key detected when reading, new images use cs800_0
+         */
+        cipher::CipherKey cipherKey = cipher::CipherKey::CS800_0;
+
+        /**
+         * Keys used by CS radios, ranked by samples of the encrypted image (best first)
+         * @note The file checksum confirms the key, later keys are only tried when it fails
+         */
+        static auto RankCiphers(const uint8_t *image, const uint32_t &len) -> std::vector<cipher::CipherKey>;
+
+        /**
+         * Checksum state after the header, the checksum covers the header and the decrypted image
+         */
+        auto HeaderChecksum() const -> radio_tool::checksum::CSState;
+
+        /**
+         * Checksum of the header and the image decrypted with cipherKey
+         */
+        auto ImageChecksum() const -> uint16_t;
         auto UpdateHeader() -> void;
     };
 } // namespace radio_tool::fw
\ No newline at end of file
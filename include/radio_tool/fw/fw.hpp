@@ -17,39 +17,81 @@
  */
 #pragma once
 
+#include <radio_tool/util/keystream.hpp>
+#include <radio_tool/util/digest.hpp>
+#include <radio_tool/fw/fw_buffer.hpp>
+#include <radio_tool/fw/fw_image.hpp>
+#include <radio_tool/fw/fw_view.hpp>
+
 #include <string>
 #include <vector>
+#include <ostream>
 #include <iterator>
+#include <optional>
+#include <algorithm>
+#include <functional>
 
 namespace radio_tool::fw
 {
+    /**
+     * View of one segment of a firmware binary
+     * @note The view is only valid until the firmware data is changed
+     */
     class FirmwareSegment
     {
     public:
-        FirmwareSegment(const uint16_t &idx, const uint32_t &addr, const uint32_t &size, const std::vector<uint8_t>::const_iterator &begin, const std::vector<uint8_t>::const_iterator &end)
-            : index(idx), address(addr), size(size), data(begin, end)
+        FirmwareSegment(const uint16_t &idx, const uint32_t &addr, const ByteView &data)
+            : index(idx), address(addr), size(static_cast<uint32_t>(data.size())), data(data)
         {
         }
 
         /**
          * Index of the segment
          */
-        const uint16_t index;
+        uint16_t index;
 
         /**
          * The address the segment should be written to on the device
          */
-        const uint32_t address;
+        uint32_t address;
 
         /**
          * The size of the data segment
          */
-        const uint32_t size;
+        uint32_t size;
+
+        /**
+         * The segment data inside the firmware binary
+         */
+        ByteView data;
 
         /**
-         * A copy of the data from the firwmare file
+         * CRC-32 of the segment data (computed on first use)
          */
-        const std::vector<uint8_t> data;
+        auto GetCRC32() const -> uint32_t
+        {
+            if (!crc32)
+            {
+                crc32 = digest::CRC32(data.data(), data.size());
+            }
+            return *crc32;
+        }
+
+        /**
+         * SHA-256 of the segment data (computed on first use)
+         */
+        auto GetSHA256() const -> const digest::SHA256Digest &
+        {
+            if (!sha256)
+            {
+                sha256 = digest::SHA256::Hash(data.data(), data.size());
+            }
+            return *sha256;
+        }
+
+    private:
+        mutable std::optional<uint32_t> crc32;
+        mutable std::optional<digest::SHA256Digest> sha256;
     };
 
     class FirmwareSupport
@@ -62,11 +104,32 @@ namespace radio_tool::fw
          */
         virtual auto Read(const std::string &fw) -> void = 0;
 
+        /**
+         * Parse only the file header, fills in the model and memory ranges but not the data
+         * @param header Start of the file, up to FirmwareFactory::SniffSize bytes
+         * @param file_size Size of the whole file
+         */
+        virtual auto ReadHeader(const ByteView &header, const uint64_t &file_size) -> void = 0;
+
         /**
          * Write the firmware file to disk
          */
         virtual auto Write(const std::string &fw) -> void = 0;
 
+        /**
+         * Wrap segment files straight into an encrypted firmware file
+         * <Address, Filename>
+         * @note Segments are read, padded, encrypted and written in chunks, they are never fully loaded
+         */
+        virtual auto WriteSegments(const std::string &fw, const std::vector<std::pair<uint32_t, std::string>> &segments) -> void = 0;
+
+        /**
+         * Decrypt each segment into its own file named prefix_0x<address>
+         * @note Segments are decrypted through a small buffer as they are written
+         * @return The files written
+         */
+        auto UnwrapSegments(const std::string &prefix) const -> std::vector<std::string>;
+
         /**
          * Returns general info about the firmware file
          */
@@ -92,55 +155,190 @@ namespace radio_tool::fw
          */
         virtual auto Encrypt() -> void = 0;
 
+        /**
+         * Get the keystream used to encrypt/decrypt this firmware
+         * @note Stream position 0 is the first byte of GetData()
+         */
+        virtual auto GetCipher() const -> keystream::CipherStream = 0;
+
+        /**
+         * Offset of the firmware binary in the firmware file
+         */
+        virtual auto GetDataOffset() const -> uint64_t = 0;
+
         /**
          * Gets the firmware binary
+         * @note May be a view of the mapped firmware file
          */
-        auto GetData() const -> const std::vector<uint8_t> &
+        auto GetData() const -> const FirmwareBuffer &
         {
             return data;
         }
 
         /**
-         * Get segments to write in the firmware
+         * CRC-32 of the whole firmware binary (computed on first use)
          */
-        virtual auto GetDataSegments() const -> const std::vector<FirmwareSegment>
+        auto GetCRC32() const -> uint32_t
         {
-            std::vector<FirmwareSegment> ret;
+            if (!crc32)
+            {
+                crc32 = digest::CRC32(data.data(), data.size());
+            }
+            return *crc32;
+        }
 
-            auto r_idx = 0u;
-            auto r_offset = 0u;
-            for(const auto& r : memory_ranges) 
+        /**
+         * SHA-256 of the whole firmware binary (computed on first use)
+         */
+        auto GetSHA256() const -> const digest::SHA256Digest &
+        {
+            if (!sha256)
+            {
+                sha256 = digest::SHA256::Hash(data.data(), data.size());
+            }
+            return *sha256;
+        }
+
+        /**
+         * Gets the memory ranges of the segments in the firmware binary
+         * <Address, Length>
+         */
+        auto GetMemoryRanges() const -> const std::vector<std::pair<uint32_t, uint32_t>> &
+        {
+            return memory_ranges;
+        }
+
+        /**
+         * Total size of all memory ranges
+         * @note Also valid when only the header was read
+         */
+        auto GetImageSize() const -> uint64_t
+        {
+            uint64_t ret = 0;
+            for (const auto &r : memory_ranges)
+            {
+                ret += r.second;
+            }
+            return ret;
+        }
+
+        /**
+         * Get segments to write in the firmware
+         * @note Segments are views of the firmware data, built on first use
+         */
+        auto GetDataSegments() const -> const std::vector<FirmwareSegment> &
+        {
+            if (!segments)
             {
-                ret.push_back(FirmwareSegment(
-                    r_idx++, 
-                    r.first, 
-                    r.second, 
-                    data.begin() + r_offset,
-                    data.begin() + r_offset + r.second
-                ));
-                r_offset += r.second;
+                std::vector<FirmwareSegment> ret;
+                ret.reserve(memory_ranges.size());
+
+                auto r_idx = 0u;
+                auto r_offset = 0u;
+                for(const auto& r : memory_ranges) 
+                {
+                    ret.emplace_back(r_idx++, r.first, data.View(r_offset, r.second));
+                    r_offset += r.second;
+                }
+                segments = std::move(ret);
             }
+            return *segments;
+        }
 
+        /**
+         * The segments as a sparse address space, extents are views of the firmware data
+         * @note Only valid until the firmware data is changed
+         */
+        auto GetImage() const -> FirmwareImage
+        {
+            FirmwareImage ret;
+            for (const auto &s : GetDataSegments())
+            {
+                ret.Add(s.address, s.data);
+            }
             return ret;
         }
 
+        /**
+         * Replace all segments with the extents of an image, in address order
+         */
+        auto SetImage(const FirmwareImage &image) -> void
+        {
+            SetSegments(image.GetExtents());
+        }
+
+        /**
+         * Decrypt the image page by page as it is read, instead of calling Decrypt
+         * @note Only valid while the data is encrypted and unchanged
+         */
+        auto GetDecryptedView() const -> DecryptedView
+        {
+            return DecryptedView(ByteView(data.data(), data.size()), GetImage(), GetCipher());
+        }
+
         /**
          * Adds a data segment to this firmware
          * @note Normally used when wrapping new firmware
-         * @remarks Data will be padded if its too short
+         * @remarks Data will be padded if its too short, new_data can be a view of a mapped file
+         */
+        virtual auto AppendSegment(const uint32_t &addr, const ByteView &new_data) -> void
+        {
+            auto new_size = PaddedSize(new_data.size());
+            auto &buf = data.Mutable();
+            if (buf.capacity() < buf.size() + new_size)
+            {
+                buf.reserve(std::max(buf.size() + new_size, buf.capacity() * 2));
+            }
+            buf.insert(buf.end(), new_data.begin(), new_data.end());
+            buf.resize(buf.size() + (new_size - new_data.size()), 0xff);
+            memory_ranges.push_back({addr, static_cast<uint32_t>(new_size)});
+            InvalidateCache();
+        }
+
+        /**
+         * Adds a data segment, the buffer is taken over if it is the first segment
+         */
+        auto AppendSegment(const uint32_t &addr, std::vector<uint8_t> &&new_data) -> void
+        {
+            if (!data.empty())
+            {
+                AppendSegment(addr, ByteView(new_data));
+                return;
+            }
+
+            auto new_size = PaddedSize(new_data.size());
+            new_data.resize(new_size, 0xff);
+            data.Assign(std::move(new_data));
+            memory_ranges.push_back({addr, static_cast<uint32_t>(new_size)});
+            InvalidateCache();
+        }
+
+        /**
+         * Replace the firmware data with a list of segments
+         * <Address, Data>
+         * @note The image is allocated once and each byte is copied once
          */
-        virtual auto AppendSegment(const uint32_t &addr, const std::vector<uint8_t> &new_data) -> void
+        auto SetSegments(const std::vector<std::pair<uint32_t, ByteView>> &segments) -> void
         {
-            auto extra = align != 0 ? new_data.size() % align : 0;
-            auto new_size = new_data.size() + (extra > 0 ? align - extra : 0);
-            data.reserve(data.size() + new_size);
-            std::copy(new_data.begin(), new_data.end(), std::back_inserter(data));
-            if(extra > 0)
+            size_t total = 0;
+            for (const auto &s : segments)
             {
-                std::fill_n(std::back_inserter(data), align - extra, 0xff);
+                total += PaddedSize(s.second.size());
             }
-            memory_ranges.push_back({addr, new_size});
-        }   
+
+            std::vector<uint8_t> buf;
+            buf.reserve(total);
+            memory_ranges.clear();
+            for (const auto &s : segments)
+            {
+                auto new_size = PaddedSize(s.second.size());
+                buf.insert(buf.end(), s.second.begin(), s.second.end());
+                buf.resize(buf.size() + (new_size - s.second.size()), 0xff);
+                memory_ranges.push_back({s.first, static_cast<uint32_t>(new_size)});
+            }
+            data.Assign(std::move(buf));
+            InvalidateCache();
+        }
 
     protected:
         /**
@@ -156,14 +354,57 @@ namespace radio_tool::fw
         const uint32_t align;
 
         /**
-         * The firmware binary
+         * Size of a segment after padding to the alignment
          */
-        std::vector<uint8_t> data;
+        auto PaddedSize(const size_t &len) const -> size_t
+        {
+            auto extra = align != 0 ? len % align : 0;
+            return len + (extra > 0 ? align - extra : 0);
+        }
+
+        /**
+         * The firmware binary, use data.Mutable() to change it
+         */
+        FirmwareBuffer data;
 
         /**
          * Memory ranges to write the firmware file to
          * <Address, Length>
          */
         std::vector<std::pair<uint32_t, uint32_t>> memory_ranges;
+
+        /**
+         * Size of the chunks used when streaming segment files
+         */
+        static constexpr size_t StreamChunkSize = 0x10000;
+
+        /**
+         * Set memory_ranges to the padded sizes of the segment files
+         * @note The data is cleared, the image is only described by memory_ranges
+         */
+        auto PlanSegments(const std::vector<std::pair<uint32_t, std::string>> &segments) -> void;
+
+        /**
+         * Read the segment files in chunks, pad them to the alignment, encrypt and write them to out
+         * @param plain Called with each plaintext chunk before it is encrypted
+         * @note The segments must match memory_ranges from PlanSegments
+         */
+        auto StreamSegments(std::ostream &out, const std::vector<std::pair<uint32_t, std::string>> &segments,
+                            const std::function<void(const uint8_t *, const size_t &)> &plain = nullptr) const -> void;
+
+        /**
+         * Clear the cached segments and digests, must be called after changing data or memory_ranges
+         */
+        auto InvalidateCache() -> void
+        {
+            segments.reset();
+            crc32.reset();
+            sha256.reset();
+        }
+
+    private:
+        mutable std::optional<std::vector<FirmwareSegment>> segments;
+        mutable std::optional<uint32_t> crc32;
+        mutable std::optional<digest::SHA256Digest> sha256;
     };
 } // namespace radio_tool::fw
\ No newline at end of file
@@ -0,0 +1,132 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <radio_tool/fw/fw.hpp>
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <functional>
+
+namespace radio_tool::fw
+{
+    /**
+     * Operation to run on each file in batch mode
+     */
+    enum class BatchOp
+    {
+        Info,
+        Unwrap
+    };
+
+    class BatchOptions
+    {
+    public:
+        BatchOp op = BatchOp::Info;
+
+        /**
+         * Directory for unwrapped segments, files are named <input filename>_0x<address>
+         * @note See FirmwareBatch::GetOutputPrefixes for inputs with the same file name
+         */
+        std::string out_dir;
+
+        /**
+         * Read and decrypt the whole image to add CRC32/SHA-256 digests to info records
+         */
+        bool digest = false;
+
+        /**
+         * Number of files processed at once, 0 = one per CPU core
+         */
+        unsigned jobs = 0;
+    };
+
+    /**
+     * Result of processing one file in batch mode
+     */
+    class BatchRecord
+    {
+    public:
+        std::string file;
+        std::string model;
+
+        /**
+         * Total size of all segments
+         */
+        uint64_t size = 0;
+
+        /**
+         * <Address, Length>
+         */
+        std::vector<std::pair<uint32_t, uint32_t>> segments;
+
+        /**
+         * Files written by unwrap
+         */
+        std::vector<std::string> outputs;
+
+        std::optional<uint32_t> crc32;
+        std::optional<digest::SHA256Digest> sha256;
+
+        /**
+         * Empty if the file was processed
+         */
+        std::string error;
+
+        /**
+         * Single line JSON object
+         */
+        auto ToJSON() const -> std::string;
+    };
+
+    class FirmwareBatch
+    {
+    public:
+        /**
+         * Expand files, directories (recursively) and globs (* and ? in the file name) to a list of files
+         * @note Inputs which match nothing are kept so they are reported as errors
+         */
+        static auto ExpandInputs(const std::vector<std::string> &inputs) -> std::vector<std::string>;
+
+        /**
+         * Match a file name against a pattern with * and ?
+         */
+        static auto GlobMatch(const char *pattern, const char *name) -> bool;
+
+        /**
+         * Unwrap output prefix of each file, out_dir/<file name>
+         * @note Files which share a file name get _<CRC32 of the input path> added,
+         *       an empty prefix means the file collides with an earlier one
+         */
+        static auto GetOutputPrefixes(const std::vector<std::string> &files, const std::string &out_dir) -> std::vector<std::string>;
+
+        /**
+         * Process a single file, errors are returned in the record
+         * @param out_prefix Prefix of the unwrapped segment files
+         */
+        static auto Process(const std::string &file, const BatchOptions &opt, const std::string &out_prefix) -> BatchRecord;
+
+        /**
+         * Process files on a worker pool
+         * @param emit Called with each record in the order of files, never concurrently
+         * @return The number of files which failed
+         */
+        static auto Run(const std::vector<std::string> &files, const BatchOptions &opt, const std::function<void(const BatchRecord &)> &emit) -> size_t;
+    };
+} // namespace radio_tool::fw
@@ -0,0 +1,100 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <radio_tool/util/span.hpp>
+#include <radio_tool/util/mapped_file.hpp>
+
+#include <vector>
+#include <memory>
+#include <stdexcept>
+
+namespace radio_tool::fw
+{
+    /**
+     * Firmware binary which is either a read-only view of a mapped file
+     * or an owned buffer, the mapping is copied on the first write
+     */
+    class FirmwareBuffer
+    {
+    public:
+        auto data() const -> const uint8_t * { return IsMapped() ? view.data() : owned.data(); }
+        auto size() const -> size_t { return IsMapped() ? view.size() : owned.size(); }
+        auto empty() const -> bool { return size() == 0; }
+        auto begin() const -> const uint8_t * { return data(); }
+        auto end() const -> const uint8_t * { return data() + size(); }
+        auto operator[](const size_t &idx) const -> const uint8_t & { return data()[idx]; }
+
+        /**
+         * View part of the buffer
+         */
+        auto View(const size_t &offset, const size_t &len) const -> ByteView
+        {
+            return ByteView(data(), size()).Sub(offset, len);
+        }
+
+        /**
+         * Reference part of a mapped file, nothing is read until its used
+         */
+        auto Map(const std::shared_ptr<const MappedFile> &mf, const size_t &offset, const size_t &len) -> void
+        {
+            if (offset > mf->GetSize() || len > mf->GetSize() - offset)
+            {
+                throw std::runtime_error("Invalid firmware file");
+            }
+            file = mf;
+            view = ByteView(mf->GetData() + offset, len);
+            owned.clear();
+            owned.shrink_to_fit();
+        }
+
+        /**
+         * Writable buffer, copies the mapped data first
+         */
+        auto Mutable() -> std::vector<uint8_t> &
+        {
+            if (IsMapped())
+            {
+                owned.assign(view.begin(), view.end());
+                view = ByteView();
+                file.reset();
+            }
+            return owned;
+        }
+
+        /**
+         * Take over a buffer, dropping any mapping
+         */
+        auto Assign(std::vector<uint8_t> &&buf) -> void
+        {
+            file.reset();
+            view = ByteView();
+            owned = std::move(buf);
+        }
+
+        /**
+         * If the data is still a view of the mapped file
+         */
+        auto IsMapped() const -> bool { return file != nullptr; }
+
+    private:
+        std::vector<uint8_t> owned;
+        std::shared_ptr<const MappedFile> file;
+        ByteView view;
+    };
+} // namespace radio_tool::fw
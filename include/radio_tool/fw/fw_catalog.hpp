@@ -0,0 +1,135 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <radio_tool/util/digest.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace radio_tool::fw
+{
+    /**
+     * One file in the firmware catalog
+     */
+    class CatalogEntry
+    {
+    public:
+        /**
+         * Path relative to the catalog directory, '/' separated
+         */
+        std::string path;
+
+        /**
+         * File size and modification time, used to skip unchanged files on update
+         */
+        uint64_t file_size = 0;
+        int64_t mtime = 0;
+
+        /**
+         * SHA-256 of the whole file
+         */
+        digest::SHA256Digest sha256 = {};
+
+        /**
+         * Name of the firmware handler, empty if the file is not a supported firmware
+         */
+        std::string handler;
+
+        std::string model;
+
+        /**
+         * Total size of all segments
+         */
+        uint64_t image_size = 0;
+
+        /**
+         * <Address, Length>
+         */
+        std::vector<std::pair<uint32_t, uint32_t>> segments;
+
+        auto IsFirmware() const -> bool
+        {
+            return !handler.empty();
+        }
+    };
+
+    /**
+     * Persistent index of a firmware directory
+     */
+    class FirmwareCatalog
+    {
+    public:
+        /**
+         * Name of the index file inside the catalog directory
+         */
+        static constexpr auto IndexName = ".radio_tool_catalog";
+
+        /**
+         * Loads the index if one exists
+         */
+        explicit FirmwareCatalog(const std::string &dir);
+
+        /**
+         * Scan the directory, only new or changed (size/mtime) files are read
+         * @return The number of files which were (re)indexed
+         */
+        auto Update() -> size_t;
+
+        /**
+         * Write the index back to the catalog directory
+         */
+        auto Save() const -> void;
+
+        /**
+         * Find catalog entries with the same content as file
+         */
+        auto Identify(const std::string &file) const -> std::vector<const CatalogEntry *>;
+
+        auto FindDigest(const digest::SHA256Digest &sha256) const -> std::vector<const CatalogEntry *>;
+
+        /**
+         * Firmware images for a radio model
+         */
+        auto FindModel(const std::string &model) const -> std::vector<const CatalogEntry *>;
+
+        auto GetEntries() const -> const std::vector<CatalogEntry> &
+        {
+            return entries;
+        }
+
+        /**
+         * Read the header and digest of a single file
+         * @param path Stored in the entry as is
+         */
+        static auto MakeEntry(const std::string &file, const std::string &path) -> CatalogEntry;
+
+    private:
+        std::string dir;
+        std::vector<CatalogEntry> entries;
+
+        std::map<digest::SHA256Digest, std::vector<size_t>> by_digest;
+        std::unordered_map<std::string, std::vector<size_t>> by_model;
+
+        auto Load() -> void;
+        auto Reindex() -> void;
+        auto GetIndexPath() const -> std::string;
+    };
+} // namespace radio_tool::fw
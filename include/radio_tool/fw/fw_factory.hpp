@@ -31,14 +31,30 @@ namespace radio_tool::fw
     {
     public:
         FirmwareSupportTest(
-            std::function<bool(const std::string &)> &&fnFile,
+            const std::string &name,
+            const std::vector<uint8_t> &magic,
+            std::function<bool(const ByteView &, const uint64_t &)> &&fnFile,
             std::function<bool(const std::string &)> &&fnRadio,
             std::function<std::unique_ptr<FirmwareSupport>()> &&fnCreate
-        ) : SupportsRadioModel(fnRadio), SupportsFirmwareFile(fnFile), CreateHandler(fnCreate)
+        ) : Name(name), Magic(magic), SupportsRadioModel(fnRadio), SupportsFirmwareFile(fnFile), CreateHandler(fnCreate)
         {
 
         }
-        const std::function<bool(const std::string &)> SupportsFirmwareFile;
+
+        /**
+         * Short name of the file format
+         */
+        const std::string Name;
+
+        /**
+         * Fixed bytes at the start of the file, empty if the format has none
+         */
+        const std::vector<uint8_t> Magic;
+
+        /**
+         * Tests the start of a file (up to FirmwareFactory::SniffSize bytes) and the total file size
+         */
+        const std::function<bool(const ByteView &, const uint64_t &)> SupportsFirmwareFile;
 
         const std::function<bool(const std::string &)> SupportsRadioModel;
 
@@ -49,28 +65,35 @@ namespace radio_tool::fw
      * All firmware handlers
      */
     const std::vector<FirmwareSupportTest> AllFirmwareHandlers = {
-        FirmwareSupportTest(TYTFW::SupportsFirmwareFile, TYTFW::SupportsRadioModel, TYTFW::Create),
-        FirmwareSupportTest(CSFW::SupportsFirmwareFile, CSFW::SupportsRadioModel, CSFW::Create)
+        FirmwareSupportTest("tyt", tyt::magic::begin, TYTFW::SupportsFirmwareFile, TYTFW::SupportsRadioModel, TYTFW::Create),
+        FirmwareSupportTest("cs", {}, CSFW::SupportsFirmwareFile, CSFW::SupportsRadioModel, CSFW::Create)
     };
 
     class FirmwareFactory
     {
     public:
+        /**
+         * Number of bytes read from the start of a file to detect its format and parse its header
+         */
+        static constexpr size_t SniffSize = 0x100;
+
         /**
          * Return a handler for the firmware file
          * @note Normally used for firmware only operations
          */
-        static auto GetFirmwareFileHandler(const std::string &file) -> std::unique_ptr<FirmwareSupport>
-        {
-            for (const auto &fn : AllFirmwareHandlers)
-            {
-                if (fn.SupportsFirmwareFile(file))
-                {
-                    return fn.CreateHandler();
-                }
-            }
-            throw std::runtime_error("Firmware file not supported");
-        }
+        static auto GetFirmwareFileHandler(const std::string &file) -> std::unique_ptr<FirmwareSupport>;
+
+        /**
+         * Return a handler with only the header of the firmware file parsed
+         * @note Costs a single small read, the payload is not loaded
+         */
+        static auto GetFirmwareFileInfo(const std::string &file) -> std::unique_ptr<FirmwareSupport>;
+
+        /**
+         * Find the handler for the start of a file
+         * @note Handlers with a matching magic are tested first, then handlers without a magic
+         */
+        static auto GetFirmwareHandler(const ByteView &header, const uint64_t &file_size) -> const FirmwareSupportTest &;
 
         /**
          * Return a handler for the firmware file
@@ -87,5 +110,10 @@ namespace radio_tool::fw
             }
             throw std::runtime_error("Firmware model not supported");
         }
+
+        /**
+         * Read the first SniffSize bytes of a file, returns the file size
+         */
+        static auto ReadPrefix(const std::string &file, std::vector<uint8_t> &prefix) -> uint64_t;
     };
 } // namespace radio_tool::fw
\ No newline at end of file
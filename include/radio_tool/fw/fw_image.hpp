@@ -0,0 +1,133 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <radio_tool/util/span.hpp>
+
+#include <map>
+#include <vector>
+#include <utility>
+#include <stdint.h>
+
+namespace radio_tool::fw
+{
+    /**
+     * Sparse device address space, a sorted set of non-overlapping extents
+     * @note Extents added with Add are views of the caller's data (like FirmwareSegment)
+     *       until they are written to, the data must outlive the image
+     */
+    class FirmwareImage
+    {
+    public:
+        /**
+         * Add an extent without copying it
+         * @throws std::runtime_error if it overlaps an existing extent
+         */
+        auto Add(const uint32_t &addr, const ByteView &data) -> void;
+
+        /**
+         * Overwrite or add bytes, every extent it overlaps or touches is merged into one
+         */
+        auto Write(const uint32_t &addr, const ByteView &data) -> void;
+
+        /**
+         * View of len bytes at addr
+         * @throws std::out_of_range unless the bytes are inside a single extent
+         */
+        auto Read(const uint32_t &addr, const size_t &len) const -> ByteView;
+
+        /**
+         * If any byte of [addr, addr + len) is mapped
+         */
+        auto Overlaps(const uint32_t &addr, const size_t &len) const -> bool;
+
+        /**
+         * If every byte of [addr, addr + len) is inside a single extent
+         */
+        auto Contains(const uint32_t &addr, const size_t &len) const -> bool;
+
+        /**
+         * Merge extents which are next to each other
+         */
+        auto Merge() -> void;
+
+        /**
+         * Copy [start, end) to a flat buffer, unmapped bytes are set to fill
+         */
+        auto Flatten(const uint32_t &start, const uint64_t &end, const uint8_t &fill = 0xff) const -> std::vector<uint8_t>;
+
+        /**
+         * Copy everything from the first to the last mapped byte, gaps are set to fill
+         */
+        auto Flatten(const uint8_t &fill = 0xff) const -> std::vector<uint8_t>
+        {
+            return empty() ? std::vector<uint8_t>() : Flatten(GetStart(), GetEnd(), fill);
+        }
+
+        /**
+         * <Address, Data> for each extent in address order
+         */
+        auto GetExtents() const -> std::vector<std::pair<uint32_t, ByteView>>;
+
+        /**
+         * First mapped address
+         */
+        auto GetStart() const -> uint32_t
+        {
+            return empty() ? 0 : extents.begin()->first;
+        }
+
+        /**
+         * One past the last mapped address
+         */
+        auto GetEnd() const -> uint64_t
+        {
+            return empty() ? 0 : extents.rbegin()->first + static_cast<uint64_t>(extents.rbegin()->second.Bytes().size());
+        }
+
+        /**
+         * Number of mapped bytes
+         */
+        auto GetSize() const -> uint64_t;
+
+        auto empty() const -> bool
+        {
+            return extents.empty();
+        }
+
+    private:
+        class Extent
+        {
+        public:
+            std::vector<uint8_t> owned;
+            ByteView view;
+
+            auto Bytes() const -> ByteView
+            {
+                return owned.empty() ? view : ByteView(owned);
+            }
+        };
+
+        /**
+         * The extent containing addr, or extents.end()
+         */
+        auto Find(const uint32_t &addr) const -> std::map<uint32_t, Extent>::const_iterator;
+
+        std::map<uint32_t, Extent> extents;
+    };
+} // namespace radio_tool::fw
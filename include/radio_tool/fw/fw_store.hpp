@@ -0,0 +1,84 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <radio_tool/util/span.hpp>
+#include <radio_tool/util/digest.hpp>
+
+#include <string>
+#include <vector>
+
+namespace radio_tool::fw
+{
+    /**
+     * Deduplicating store for firmware files
+     * 
+     * Each file is kept as a recipe of content-defined chunks, the firmware binary is
+     * stored decrypted so unchanged code is shared between releases and radio variants.
+     * Header and footer bytes are stored as they are, so files are rebuilt bit-exactly.
+     */
+    class FirmwareStore
+    {
+    public:
+        /**
+         * Chunk boundaries are placed where the rolling hash has AvgChunkMask bits clear
+         */
+        static constexpr size_t MinChunkSize = 0x800;
+        static constexpr size_t MaxChunkSize = 0x10000;
+        static constexpr uint64_t AvgChunkMask = 0x1fff; // ~8 KiB
+
+        /**
+         * Opens (or creates) a store directory
+         */
+        explicit FirmwareStore(const std::string &dir);
+
+        /**
+         * Add a firmware file under a name
+         * @return The number of bytes of new chunks written
+         */
+        auto Add(const std::string &file, const std::string &name) const -> uint64_t;
+
+        /**
+         * Rebuild the file stored under name
+         * @note The output is checked against the SHA-256 of the original file
+         */
+        auto Extract(const std::string &name, const std::string &out) const -> void;
+
+        /**
+         * Names of all stored files
+         */
+        auto List() const -> std::vector<std::string>;
+
+        /**
+         * Split data into content-defined chunks
+         * @return The length of each chunk
+         */
+        static auto Chunk(const ByteView &data) -> std::vector<size_t>;
+
+    private:
+        std::string dir;
+
+        auto GetRecipePath(const std::string &name) const -> std::string;
+        auto GetChunkPath(const digest::SHA256Digest &id) const -> std::string;
+
+        /**
+         * Write a chunk if its not already stored, returns true if it was written
+         */
+        auto PutChunk(const ByteView &data, digest::SHA256Digest &id) const -> bool;
+    };
+} // namespace radio_tool::fw
@@ -0,0 +1,94 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <radio_tool/util/keystream.hpp>
+#include <radio_tool/util/span.hpp>
+#include <radio_tool/fw/fw_image.hpp>
+
+#include <vector>
+#include <stdint.h>
+
+namespace radio_tool::fw
+{
+    /**
+     * Decrypted view of an encrypted firmware image, pages are decrypted on first use
+     * and kept in a small cache
+     * @note The encrypted image must not change while the view is in use
+     * @remarks Not thread safe, use one view per thread
+     */
+    class DecryptedView
+    {
+    public:
+        /**
+         * Size of each decrypted page
+         */
+        static constexpr size_t PageSize = 0x1000;
+
+        /**
+         * Number of decrypted pages which are kept
+         */
+        static constexpr size_t CachePages = 8;
+
+        /**
+         * @param encrypted The image, byte 0 is at keystream position 0
+         * @param image The segments of the image, extents must be views of encrypted
+         */
+        DecryptedView(const ByteView &encrypted, FirmwareImage &&image, keystream::CipherStream &&cipher)
+            : encrypted(encrypted), image(std::move(image)), cipher(std::move(cipher)), use_counter(0)
+        {
+        }
+
+        auto GetSize() const -> uint64_t
+        {
+            return encrypted.size();
+        }
+
+        /**
+         * Decrypt len bytes from an image offset into out
+         */
+        auto Read(const uint64_t &offset, uint8_t *out, const size_t &len) const -> void;
+
+        /**
+         * Decrypt len bytes from a device address into out
+         * @note The bytes must be inside a single segment
+         */
+        auto ReadAddress(const uint32_t &addr, uint8_t *out, const size_t &len) const -> void;
+
+        /**
+         * A decrypted page of the image, the last page may be short
+         * @note The view is only valid until CachePages other pages have been read
+         */
+        auto GetPage(const uint64_t &page) const -> ByteView;
+
+    private:
+        class CachedPage
+        {
+        public:
+            uint64_t page;
+            uint64_t last_use;
+            std::vector<uint8_t> data;
+        };
+
+        ByteView encrypted;
+        FirmwareImage image;
+        keystream::CipherStream cipher;
+        mutable std::vector<CachedPage> cache;
+        mutable uint64_t use_counter;
+    };
+} // namespace radio_tool::fw
@@ -0,0 +1,59 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <radio_tool/fw/fw.hpp>
+#include <radio_tool/util/span.hpp>
+
+#include <string>
+#include <vector>
+
+namespace radio_tool::fw
+{
+    /**
+     * One firmware file to build from a set of segments
+     */
+    class WrapTarget
+    {
+    public:
+        std::string radio;
+        std::string file;
+    };
+
+    class FirmwareWrap
+    {
+    public:
+        /**
+         * Expand a comma separated list of radio models
+         * @note A TYT firmware model (e.g. MD-9600) expands to every radio model which uses it
+         */
+        static auto ExpandTargets(const std::string &radios) -> std::vector<std::string>;
+
+        /**
+         * Output file for one of many targets, the radio model is added before the extension
+         * (fw.bin -> fw_UV3X0_GPS.bin)
+         */
+        static auto GetOutputName(const std::string &out, const std::string &radio) -> std::string;
+
+        /**
+         * Pad the segments once and then encrypt and write every target in parallel
+         * @note All targets must use the same firmware handler
+         */
+        static auto Run(const std::vector<WrapTarget> &targets, const std::vector<std::pair<uint32_t, ByteView>> &segments) -> void;
+    };
+} // namespace radio_tool::fw
@@ -18,15 +18,17 @@
 #pragma once
 
 #include <radio_tool/fw/fw.hpp>
-#include <radio_tool/fw/cipher/uv3x0.hpp>
-#include <radio_tool/fw/cipher/dm1701.hpp>
-#include <radio_tool/fw/cipher/md380.hpp>
-#include <radio_tool/fw/cipher/md9600.hpp>
+#include <radio_tool/fw/cipher/cipher.hpp>
+#include <radio_tool/util/perfect_hash.hpp>
 
 #include <fstream>
 #include <cstring>
 #include <sstream>
 #include <iomanip>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <initializer_list>
 
 namespace radio_tool::fw
 {
@@ -36,8 +38,8 @@ namespace radio_tool::fw
     class TYTRadioConfig
     {
     public:
-        TYTRadioConfig(const std::string &model, const std::string &fw_model, const std::vector<uint8_t> &c_magic, const uint8_t *cipher, const uint32_t &cipher_l)
-            : radio_model(model), firmware_model(fw_model), counter_magic(c_magic), cipher(cipher), cipher_len(cipher_l)
+        TYTRadioConfig(const std::string &model, const std::string &fw_model, const std::vector<uint8_t> &c_magic, const cipher::CipherKey &cipher)
+            : radio_model(model), firmware_model(fw_model), counter_magic(c_magic), cipher(cipher)
         {
         }
 
@@ -57,14 +59,9 @@ namespace radio_tool::fw
         const std::vector<uint8_t> counter_magic;
 
         /**
-         * The cipher key for encrypting/decrypting the firmwar
+         * The cipher key for encrypting/decrypting the firmware
          */
-        const uint8_t *cipher;
-
-        /**
-         * The length of the cipher
-         */
-        const uint32_t cipher_len;
+        const cipher::CipherKey cipher;
     };
 
     namespace tyt::magic
@@ -76,44 +73,141 @@ namespace radio_tool::fw
         //OutSecurityBinEnd
         const std::vector<uint8_t> end = {0x4f, 0x75, 0x74, 0x70, 0x75, 0x74, 0x42, 0x69, 0x6e, 0x44, 0x61, 0x74, 0x61, 0x45, 0x6e, 0x64};
 
+        /**
+         * Pack a counter magic sequence [length, bytes..] into a uint32_t (little endian)
+         * @returns 0 if the sequence is not a valid counter magic
+         */
+        constexpr auto PackCounterMagic(const uint8_t *cm, const size_t &len) -> uint32_t
+        {
+            if (len < 2 || len > 4 || cm[0] != len - 1)
+            {
+                return 0;
+            }
+            uint32_t ret = 0;
+            for (size_t x = 0; x < len; x++)
+            {
+                ret |= static_cast<uint32_t>(cm[x]) << (x * 8);
+            }
+            return ret;
+        }
+
+        constexpr auto PackCounterMagic(const std::initializer_list<uint8_t> &cm) -> uint32_t
+        {
+            return PackCounterMagic(cm.begin(), cm.size());
+        }
+
+        /**
+         * Unpack a counter magic packed with PackCounterMagic
+         */
+        inline auto UnpackCounterMagic(const uint32_t &cm) -> std::vector<uint8_t>
+        {
+            std::vector<uint8_t> ret(1 + (cm & 0xff));
+            for (size_t x = 0; x < ret.size(); x++)
+            {
+                ret[x] = (cm >> (x * 8)) & 0xff;
+            }
+            return ret;
+        }
+
         /*
          * +GPS = Both GPS and Non-GPS versions have the same magic value
          * CSV = DMR Database upload as CSV support
          * REC = Recording
          */
-        const std::vector<uint8_t> MD2017_D = {0x02, 0x19, 0x0c}; //MD-2017 (REC)
-        const std::vector<uint8_t> MD2017_S = {0x02, 0x18, 0x0c}; //MD-2017 GPS (REC)
-        const std::vector<uint8_t> MD2017_V = {0x01, 0x19};       //MD-2017 (CSV)
-        const std::vector<uint8_t> MD2017_P = {0x01, 0x18};       //MD-2017 GPS (CSV)
+        constexpr uint32_t MD2017_D = PackCounterMagic({0x02, 0x19, 0x0c}); //MD-2017 (REC)
+        constexpr uint32_t MD2017_S = PackCounterMagic({0x02, 0x18, 0x0c}); //MD-2017 GPS (REC)
+        constexpr uint32_t MD2017_V = PackCounterMagic({0x01, 0x19});       //MD-2017 (CSV)
+        constexpr uint32_t MD2017_P = PackCounterMagic({0x01, 0x18});       //MD-2017 GPS (CSV)
 
-        const std::vector<uint8_t> MD9600 = {0x01, 0x14}; //MD-9600 (REC/CSV) +GPS
+        constexpr uint32_t MD9600 = PackCounterMagic({0x01, 0x14}); //MD-9600 (REC/CSV) +GPS
 
-        const std::vector<uint8_t> UV3X0_GPS = {0x02, 0x16, 0x0c}; //MD-UV3X0 (REC/CSV)(GPS) / RT3S
-        const std::vector<uint8_t> UV3X0 = {0x02, 0x17, 0x0c};     //MD-UV3X0 (REC/CSV) / RT3S
+        constexpr uint32_t UV3X0_GPS = PackCounterMagic({0x02, 0x16, 0x0c}); //MD-UV3X0 (REC/CSV)(GPS) / RT3S
+        constexpr uint32_t UV3X0 = PackCounterMagic({0x02, 0x17, 0x0c});     //MD-UV3X0 (REC/CSV) / RT3S
 
-        const std::vector<uint8_t> DM1701 = {0x01, 0x0f}; //DM-1701
+        constexpr uint32_t DM1701 = PackCounterMagic({0x01, 0x0f}); //DM-1701
 
-        const std::vector<uint8_t> MD390 = {0x01, 0x10}; //MD-390
-        const std::vector<uint8_t> MD380 = {0x01, 0x0d}; //MD-380 / MD-446
-        const std::vector<uint8_t> MD280 = {0x01, 0x1b}; //MD-280
+        constexpr uint32_t MD390 = PackCounterMagic({0x01, 0x10}); //MD-390
+        constexpr uint32_t MD380 = PackCounterMagic({0x01, 0x0d}); //MD-380 / MD-446
+        constexpr uint32_t MD280 = PackCounterMagic({0x01, 0x1b}); //MD-280
     } // namespace tyt::magic
 
     namespace tyt::config
     {
-        const std::vector<TYTRadioConfig> All = {
-            TYTRadioConfig("MD2017" /* REC */, "MD-9600", tyt::magic::MD2017_D, cipher::uv3x0, cipher::uv3x0_length),
-            TYTRadioConfig("MD2017 GPS" /* REC */, "MD-9600", tyt::magic::MD2017_S, cipher::uv3x0, cipher::uv3x0_length),
-            TYTRadioConfig("MD2017" /* CSV */, "MD-9600", tyt::magic::MD2017_V, cipher::uv3x0, cipher::uv3x0_length),
-            TYTRadioConfig("MD2017 GPS" /* CSV */, "MD-9600", tyt::magic::MD2017_P, cipher::uv3x0, cipher::uv3x0_length),
-            TYTRadioConfig("MD9600", "MD-9600", tyt::magic::MD9600, cipher::md9600, cipher::md9600_length),
-            TYTRadioConfig("UV3X0 GPS", "MD-9600", tyt::magic::UV3X0_GPS, cipher::uv3x0, cipher::uv3x0_length),
-            TYTRadioConfig("UV3X0", "MD-9600", tyt::magic::UV3X0, cipher::uv3x0, cipher::uv3x0_length),
-            TYTRadioConfig("DM1701", "DM1701", tyt::magic::DM1701, cipher::dm1701, cipher::dm1701_length),
-            TYTRadioConfig("MD390", "JST51", tyt::magic::MD390, cipher::md380, cipher::md380_length),
-            TYTRadioConfig("MD380", "JST51", tyt::magic::MD380, cipher::md380, cipher::md380_length),
-            TYTRadioConfig("MD446", "JST51", tyt::magic::MD380, cipher::md380, cipher::md380_length),
-            TYTRadioConfig("MD280", "JST51", tyt::magic::MD280, cipher::md380, cipher::md380_length)
+        /**
+         * Compile time config for each TYT radio model
+         */
+        struct TYTRadioEntry
+        {
+            const char *radio_model;
+            const char *firmware_model;
+            uint32_t counter_magic;
+            cipher::CipherKey cipher;
         };
+
+        constexpr TYTRadioEntry Radios[] = {
+            {"MD2017" /* REC */, "MD-9600", tyt::magic::MD2017_D, cipher::CipherKey::UV3X0},
+            {"MD2017 GPS" /* REC */, "MD-9600", tyt::magic::MD2017_S, cipher::CipherKey::UV3X0},
+            {"MD2017" /* CSV */, "MD-9600", tyt::magic::MD2017_V, cipher::CipherKey::UV3X0},
+            {"MD2017 GPS" /* CSV */, "MD-9600", tyt::magic::MD2017_P, cipher::CipherKey::UV3X0},
+            {"MD9600", "MD-9600", tyt::magic::MD9600, cipher::CipherKey::MD9600},
+            {"UV3X0 GPS", "MD-9600", tyt::magic::UV3X0_GPS, cipher::CipherKey::UV3X0},
+            {"UV3X0", "MD-9600", tyt::magic::UV3X0, cipher::CipherKey::UV3X0},
+            {"DM1701", "DM1701", tyt::magic::DM1701, cipher::CipherKey::DM1701},
+            {"MD390", "JST51", tyt::magic::MD390, cipher::CipherKey::MD380},
+            {"MD380", "JST51", tyt::magic::MD380, cipher::CipherKey::MD380},
+            {"MD446", "JST51", tyt::magic::MD380, cipher::CipherKey::MD380},
+            {"MD280", "JST51", tyt::magic::MD280, cipher::CipherKey::MD380}};
+
+        constexpr auto RadioCount = sizeof(Radios) / sizeof(Radios[0]);
+
+        /**
+         * Perfect hash of Radios by packed counter magic, first entry wins
+         */
+        constexpr hash::PerfectHash<RadioCount> MagicIndex([]() constexpr {
+            std::array<uint32_t, RadioCount> ret{};
+            for (size_t x = 0; x < RadioCount; x++)
+                ret[x] = Radios[x].counter_magic;
+            return ret;
+        }());
+
+        /**
+         * Perfect hash of Radios by radio model, first entry wins
+         */
+        constexpr hash::PerfectHash<RadioCount> ModelIndex([]() constexpr {
+            std::array<uint32_t, RadioCount> ret{};
+            for (size_t x = 0; x < RadioCount; x++)
+                ret[x] = hash::FNV1a(Radios[x].radio_model);
+            return ret;
+        }());
+
+        /**
+         * Find a radio by its packed counter magic
+         * @returns nullptr if the counter magic is not known
+         */
+        constexpr auto FindByMagic(const uint32_t &cm) -> const TYTRadioEntry *
+        {
+            auto idx = MagicIndex.Find(cm);
+            return idx < 0 ? nullptr : &Radios[idx];
+        }
+
+        /**
+         * Find a radio by its radio model
+         * @returns nullptr if the model is not known
+         */
+        constexpr auto FindByModel(const std::string_view &model) -> const TYTRadioEntry *
+        {
+            auto idx = ModelIndex.Find(hash::FNV1a(model));
+            return idx < 0 || model != Radios[idx].radio_model ? nullptr : &Radios[idx];
+        }
+
+        const std::vector<TYTRadioConfig> All = []() {
+            std::vector<TYTRadioConfig> ret;
+            for (const auto &r : Radios)
+            {
+                ret.emplace_back(r.radio_model, r.firmware_model, tyt::magic::UnpackCounterMagic(r.counter_magic), r.cipher);
+            }
+            return ret;
+        }();
     }
     /**
      * Stores the start of the TYT Firmware file header
@@ -133,35 +227,49 @@ namespace radio_tool::fw
     public:
         TYTFW() {}
         TYTFW(const std::vector<uint8_t> &cMagic)
-            : counterMagic(cMagic), FirmwareSupport(0x200)
-        { }
+            : FirmwareSupport(0x200)
+        {
+            SetCounterMagic(cMagic);
+        }
 
         auto Read(const std::string &file) -> void override;
+        auto ReadHeader(const ByteView &header, const uint64_t &file_size) -> void override;
         auto Write(const std::string &file) -> void override;
+        auto WriteSegments(const std::string &file, const std::vector<std::pair<uint32_t, std::string>> &segments) -> void override;
         auto ToString() const -> std::string override;
         auto Decrypt() -> void override;
         auto Encrypt() -> void override;
+        auto GetCipher() const -> keystream::CipherStream override;
+
+        auto GetDataOffset() const -> uint64_t override
+        {
+            return HeaderSize;
+        }
         auto SetRadioModel(const std::string&) -> void override;
 
         /**
          * @note This is not the "firmware_model" which exists in the firmware header
+         * @returns UnknownRadio if the counter magic is not in tyt::config
          */
         auto GetRadioModel() const -> const std::string override;
 
+        /**
+         * Radio model of files with a counter magic which is not in tyt::config
+         */
+        static constexpr auto UnknownRadio = "unknown";
+
         /**
          * Get the counter magic for a specific model radio
          * @note This is the radio model not the model from the firmware file
          */
         static auto GetCounterMagic(const std::string &radio) -> const std::vector<uint8_t>
         {
-            for (const auto &r : tyt::config::All)
+            auto r = tyt::config::FindByModel(radio);
+            if (r == nullptr)
             {
-                if (r.radio_model == radio)
-                {
-                    return r.counter_magic;
-                }
+                throw std::runtime_error("Radio not supported");
             }
-            throw std::runtime_error("Radio not supported");
+            return tyt::magic::UnpackCounterMagic(r->counter_magic);
         }
 
         /**
@@ -170,23 +278,28 @@ namespace radio_tool::fw
          */
         static auto GetRadioFromMagic(const std::vector<uint8_t> &cm) -> const std::string
         {
-            for (const auto &r : tyt::config::All)
+            auto r = tyt::config::FindByMagic(tyt::magic::PackCounterMagic(cm.data(), cm.size()));
+            if (r == nullptr)
             {
-                if (r.counter_magic.size() != cm.size())
-                    continue;
-                /* GCC doesnt seem to mind which is longer, MSVC tries to read past the end of [first2] */
-                if (std::equal(cm.begin(), cm.end(), r.counter_magic.begin()))
-                {
-                    return r.radio_model;
-                }
+                throw std::runtime_error("Radio not supported");
             }
-            throw std::runtime_error("Radio not supported");
+            return r->radio_model;
         }
 
         /**
-         * Tests a file if its a valid firmware file
+         * Size of the file header including the memory region table
+         */
+        static constexpr auto HeaderSize = 0x100u;
+
+        /**
+         * 0xFF padding between the data and the end magic
+         */
+        static constexpr auto FooterPadding = 0x100u - 16;
+
+        /**
+         * Tests the start of a file if its a valid firmware file
          */
-        static auto SupportsFirmwareFile(const std::string &file) -> bool;
+        static auto SupportsFirmwareFile(const ByteView &header, const uint64_t &file_size) -> bool;
 
         /**
          * Tests if a radio model is supported by this firmware handler
@@ -204,13 +317,24 @@ namespace radio_tool::fw
     private:
         std::vector<uint8_t> counterMagic; //2-3 bytes
 
+        /**
+         * Cipher for counterMagic, resolved when the counter magic is set
+         */
+        std::optional<cipher::CipherKey> cipherKey;
+
         uint32_t n1,
             n2, // appears to be some kind of bootloader version
             n3, n4;
         std::string firmware_model, radio_model;
 
-        static auto ReadHeader(std::ifstream &) -> TYTFirmwareHeader;
+        static auto ParseHeader(const ByteView &) -> TYTFirmwareHeader;
+
+        /**
+         * Build the file header and region table for the current memory ranges (HeaderSize bytes)
+         */
+        auto MakeHeader() const -> std::vector<uint8_t>;
         static auto CheckHeader(const TYTFirmwareHeader &) -> void;
+        auto SetCounterMagic(const std::vector<uint8_t> &) -> void;
         auto ApplyXOR() -> void;
     };
 
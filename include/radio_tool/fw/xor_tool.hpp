@@ -0,0 +1,75 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <radio_tool/fw/fw.hpp>
+
+#include <vector>
+#include <stdint.h>
+
+namespace radio_tool::fw
+{
+    /**
+     * Recovers the XOR key of encrypted firmware using known plaintext
+     */
+    class XORTool
+    {
+    public:
+        /**
+         * Key length used by TYT firmware, 0x100 byte keys repeat inside it
+         */
+        static constexpr uint32_t DefaultKeyLength = 0x400;
+
+        /**
+         * Recover the XOR key of an encrypted firmware binary
+         * @param fill The plaintext value assumed for padding, erased flash is 0xFF
+         * @note Every key column is voted on using the bytes which repeat one key period later,
+         *       which happens in padding runs where the plaintext is constant
+         */
+        static auto MakeXOR(const std::vector<uint8_t> &data, const uint32_t &key_len = DefaultKeyLength, const uint8_t &fill = 0xff) -> std::vector<uint8_t>;
+
+        /**
+         * Recover the XOR key of a firmware file, picking the padding value
+         * which makes its segments decrypt to valid vector tables
+         */
+        static auto MakeXOR(const FirmwareSupport &fw, const uint32_t &key_len = DefaultKeyLength) -> std::vector<uint8_t>;
+
+        /**
+         * Test if the start of a segment decrypts to a valid Cortex-M vector table
+         * @param key_offset Position in the key of the first byte of the segment
+         */
+        static auto Verify(const uint32_t &address, const ByteView &data, const std::vector<uint8_t> &key, const uint32_t &key_offset = 0) -> bool;
+
+        /**
+         * Score (0-1) how much a decrypted buffer looks like a STM32F4 vector table
+         * @note Entries must point to SRAM (stack) or to code inside the STM32F40X flash map
+         */
+        static auto ScoreVectorTable(const uint8_t *data, const size_t &len) -> double;
+
+    private:
+        /**
+         * Most common repeating ciphertext byte of each key column
+         */
+        static auto VoteColumns(const ByteView &data, const uint32_t &key_len) -> std::vector<uint8_t>;
+
+        /**
+         * Total vector table score of the segments inside the MCU flash
+         */
+        static auto ScoreSegments(const FirmwareSupport &fw, const std::vector<uint8_t> &key) -> double;
+    };
+} // namespace radio_tool::fw
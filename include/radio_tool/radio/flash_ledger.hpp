@@ -0,0 +1,63 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <string>
+#include <optional>
+
+namespace radio_tool::radio
+{
+    /**
+     * Record of the firmware file last flashed to each radio
+     * @note Entries are removed before flashing and stored after a successful flash,
+     *       so an interrupted flash never leaves a stale entry behind
+     */
+    class FlashLedger
+    {
+    public:
+        /**
+         * @param radio_id Identity of a single radio unit (not model), used as the file name
+         * @throws std::invalid_argument unless it is 1-64 characters of [A-Za-z0-9_-]
+         * @param dir Ledger directory, empty = GetDefaultDir()
+         */
+        FlashLedger(const std::string &radio_id, const std::string &dir = "");
+
+        /**
+         * RADIO_TOOL_LEDGER, or radio_tool/ledger in the user data directory
+         */
+        static auto GetDefaultDir() -> std::string;
+
+        /**
+         * Path of the installed firmware file, if there is one
+         */
+        auto GetInstalled() const -> std::optional<std::string>;
+
+        /**
+         * Forget the installed firmware, call before the flash is changed
+         */
+        auto Invalidate() const -> void;
+
+        /**
+         * Record the firmware file which is now installed
+         */
+        auto Store(const std::string &fw_file) const -> void;
+
+    private:
+        std::string path;
+    };
+} // namespace radio_tool::radio
@@ -20,6 +20,7 @@
 #include <radio_tool/dfu/dfu.hpp>
 
 #include <string>
+#include <optional>
 #include <iomanip>
 
 namespace radio_tool::radio
@@ -53,8 +54,11 @@ namespace radio_tool::radio
 
         /**
          * Write a firmware file to the device (Firmware Upgrade)
+         * @param delta_id Identity of this radio unit, only write sectors which differ from the last
+         *                 image flashed to it with this tool. Without it everything is written and
+         *                 the flash ledger is not used
          */
-        virtual auto WriteFirmware(const std::string &file) const -> void = 0;
+        virtual auto WriteFirmware(const std::string &file, const std::optional<std::string> &delta_id) const -> void = 0;
         
         //virtual auto WriteCodeplug();
         //virtual auto ReadCodeplug();
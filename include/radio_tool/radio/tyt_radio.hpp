@@ -21,6 +21,7 @@
 #include <radio_tool/dfu/tyt_dfu.hpp>
 
 #include <functional>
+#include <memory>
 
 namespace radio_tool::radio
 {
@@ -30,7 +31,7 @@ namespace radio_tool::radio
         TYTRadio(libusb_device_handle* h)
             : dfu(h) {}
 
-        auto WriteFirmware(const std::string &file) const -> void override;
+        auto WriteFirmware(const std::string &file, const std::optional<std::string> &delta_id) const -> void override;
         auto ToString() const -> const std::string override;
 
         static auto SupportsDevice(const libusb_device_descriptor &dev) -> bool
@@ -17,6 +17,9 @@
  */
 #pragma once
 
+#include <radio_tool/util/keystream.hpp>
+#include <radio_tool/util/checksum.hpp>
+
 #include <vector>
 #include <stdint.h>
 #include <iostream>
@@ -111,91 +114,69 @@ namespace radio_tool
         };
     }
 
-    static inline auto ApplyXOR(std::vector<uint8_t> &data, const uint8_t *xor_key, const uint16_t &key_len) -> void
+    /**
+     * XOR data with a repeating key
+     * @param key_offset Position in the key of the first byte
+     */
+    static inline auto ApplyXOR(std::vector<uint8_t> &data, const uint8_t *xor_key, const uint16_t &key_len, const uint32_t &key_offset = 0) -> void
     {
-        for (auto z = 0; z < data.size(); z++)
-        {
-            data[z] = data[z] ^ xor_key[z % key_len];
-        }
+        keystream::Apply(data.data(), data.size(), xor_key, key_len, key_offset);
     }
 
-    static inline auto ApplyXOR(std::vector<uint8_t>::iterator &&begin, std::vector<uint8_t>::iterator &&end, const uint8_t *xor_key, const uint16_t &key_len) -> void
+    static inline auto ApplyXOR(std::vector<uint8_t>::iterator &&begin, std::vector<uint8_t>::iterator &&end, const uint8_t *xor_key, const uint16_t &key_len, const uint32_t &key_offset = 0) -> void
     {
-        auto z = 0;
-        while(begin != end)
+        if (begin != end)
         {
-            (*begin) = (*begin) ^ xor_key[z++ % key_len];
-            std::advance(begin, 1);
+            keystream::Apply(&(*begin), std::distance(begin, end), xor_key, key_len, key_offset);
         }
     }
 
+    /**
+     * BSD checksum, data is advanced by size
+     */
     static auto BSDChecksum(std::vector<uint8_t>::iterator &data, const uint32_t &size) -> const uint16_t
     {
-        int32_t checksum = 0u;
-
-        for (auto i = 0; i < size; i++)
-        {
-            checksum = (checksum >> 1) + ((checksum & 1) << 15);
-            checksum += *data;
-            checksum &= 0xffff;
-            std::advance(data, 1);
-        }
-        return checksum;
+        auto ret = checksum::BSD(&(*data), size);
+        std::advance(data, size);
+        return ret;
     }
 
+    /**
+     * Fletcher-16 checksum, data is advanced by size
+     */
     static auto Fletcher16(std::vector<uint8_t>::iterator &data, const uint32_t &size) -> uint16_t
     {
-        constexpr auto block_size = 5802;
-        uint32_t c0 = 0, c1 = 0;
-        uint32_t i;
-        int32_t len = size;
-
-        // Found by solving for c1 overflow:
-        // n > 0 and n * (n+1) / 2 * (2^8-1) < (2^32-1).
-        for (c0 = c1 = 0; len > 0; len -= block_size)
-        {
-            auto blocklen = std::min(block_size, len);
-            for (i = 0; i < blocklen; ++i)
-            {
-                c0 = c0 + (*data);
-                c1 = c1 + c0;
-                std::advance(data, 1);
-            }
-            c0 = c0 % 255;
-            c1 = c1 % 255;
-        }
-        //auto f0 = c0;
-        //c0 = 0xff - ((c0 + c1) % 0xff);
-        //c1 = 0xff - ((f0 + c0) % 0xff);
-        return (c1 << 8 | c0);
+        auto ret = checksum::Fletcher16(&(*data), size);
+        std::advance(data, size);
+        return ret;
     }
 
+    /**
+     * Internet checksum (RFC 1071), data is advanced by size
+     */
     static auto InternetChecksum(std::vector<uint8_t>::iterator &data, const uint32_t &size) -> uint16_t
     {
-        int32_t sum = 0, 
-            count = size;
-
-        // Main summing loop
-        while (count > 1)
-        {
-            sum = sum + (*data);
-            count = count - 2;
-            std::advance(data, 1);
-        }
-
-        // Add left-over byte, if any
-        if (count > 0)
-        {
-            sum = sum + (*data);
-        }
+        auto ret = checksum::Internet(&(*data), size);
+        std::advance(data, size);
+        return ret;
+    }
 
-        // Fold 32-bit sum to 16 bits
-        while (sum >> 16)
-        {
-            sum = (sum & 0xFFFF) + (sum >> 16);
-        }
+    /**
+     * Connect Systems checksum from the 16bit sum of all bytes
+     */
+    static constexpr auto CSChecksum(const uint16_t &sum) -> uint16_t
+    {
+        return checksum::CSState::FromSum(sum);
+    }
 
-        return (~sum);
+    /**
+     * Connect Systems checksum
+     */
+    static auto CSChecksum(const uint8_t *data, const size_t &len) -> uint16_t
+    {
+        checksum::CSState s;
+        s.Update(data, len);
+        return s.Finalize();
     }
 
     /**
@@ -203,16 +184,6 @@ namespace radio_tool
      */
     static auto CSChecksum(std::vector<uint8_t>::const_iterator &&begin, const std::vector<uint8_t>::const_iterator &&end) -> uint16_t
     {
-        uint16_t sum = 0;
-
-        while(begin != end)
-        {
-            sum += (*begin);
-            std::advance(begin, 1);
-        }
-
-        auto c0 = (int32_t)(sum / 5) >> 8;
-	    auto c1 = (sum / 5) & 0xff;
-        return (c1 << 8 | c0);
+        return begin == end ? CSChecksum(0) : CSChecksum(&(*begin), std::distance(begin, end));
     }
 } // namespace radio_tool
\ No newline at end of file
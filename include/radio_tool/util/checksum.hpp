@@ -0,0 +1,155 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace radio_tool::checksum
+{
+    /**
+     * Running Connect Systems checksum (16bit sum of all bytes)
+     */
+    class CSState
+    {
+    public:
+        /**
+         * @param sum Sum of any bytes already counted (e.g. the header)
+         */
+        explicit CSState(const uint64_t &sum = 0, const uint64_t &length = 0)
+            : sum(sum), length(length) {}
+
+        auto Update(const uint8_t *data, const size_t &len) -> void;
+
+        /**
+         * Append the state of the data which follows this state
+         */
+        auto Combine(const CSState &other) -> void;
+        auto Finalize() const -> uint16_t;
+
+        auto GetSum() const -> uint64_t { return sum; }
+        auto GetLength() const -> uint64_t { return length; }
+
+        /**
+         * Checksum from the 16bit sum of all bytes
+         */
+        static constexpr auto FromSum(const uint16_t &sum) -> uint16_t
+        {
+            auto c0 = (int32_t)(sum / 5) >> 8;
+            auto c1 = (sum / 5) & 0xff;
+            return (c1 << 8 | c0);
+        }
+
+    private:
+        uint64_t sum;
+        uint64_t length;
+    };
+
+    /**
+     * Running Fletcher-16 checksum
+     */
+    class Fletcher16State
+    {
+    public:
+        auto Update(const uint8_t *data, const size_t &len) -> void;
+
+        /**
+         * Append the state of the data which follows this state
+         * @note c1 gains c0 once for every byte of the other data
+         */
+        auto Combine(const Fletcher16State &other) -> void;
+        auto Finalize() const -> uint16_t;
+
+        auto GetLength() const -> uint64_t { return length; }
+
+    private:
+        uint32_t c0 = 0, c1 = 0;
+        uint64_t length = 0;
+    };
+
+    /**
+     * Running Internet checksum (RFC 1071)
+     */
+    class InternetState
+    {
+    public:
+        auto Update(const uint8_t *data, const size_t &len) -> void;
+
+        /**
+         * Append the state of the data which follows this state
+         * @note If this state ends on an odd byte the other sum is byte swapped
+         */
+        auto Combine(const InternetState &other) -> void;
+        auto Finalize() const -> uint16_t;
+
+        auto GetLength() const -> uint64_t { return length; }
+
+    private:
+        /**
+         * Ones complement sum of little endian words
+         */
+        uint64_t sum = 0;
+        uint64_t length = 0;
+
+        auto Add(uint64_t s, const bool &swap) -> void;
+    };
+
+    /**
+     * Running BSD checksum
+     * @note No Combine, the rotation makes the result depend on the state before each byte
+     */
+    class BSDState
+    {
+    public:
+        auto Update(const uint8_t *data, const size_t &len) -> void;
+        auto Finalize() const -> uint16_t;
+
+        auto GetLength() const -> uint64_t { return length; }
+
+    private:
+        uint32_t checksum = 0;
+        uint64_t length = 0;
+    };
+
+    /**
+     * Sum of all bytes
+     */
+    auto Sum(const uint8_t *data, const size_t &len) -> uint64_t;
+
+    /**
+     * Fletcher-16 checksum, (c1 << 8) | c0
+     */
+    auto Fletcher16(const uint8_t *data, const size_t &len) -> uint16_t;
+
+    /**
+     * Internet checksum (RFC 1071) of 16bit big endian words
+     * @note An odd trailing byte is padded with zero
+     */
+    auto Internet(const uint8_t *data, const size_t &len) -> uint16_t;
+
+    /**
+     * BSD checksum (16bit rotating sum)
+     * @note Each step depends on the previous rotation so this is always scalar
+     */
+    auto BSD(const uint8_t *data, const size_t &len) -> uint16_t;
+
+    /**
+     * Name of the checksum kernels selected for this CPU
+     */
+    auto GetKernelName() -> const char *;
+} // namespace radio_tool::checksum
@@ -0,0 +1,65 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define RADIO_TOOL_X86
+#endif
+
+/**
+ * Compile a single function for an instruction set extension, selected at runtime with GetFeatures
+ * @note MSVC allows intrinsics of any extension without a target
+ */
+#if defined(_MSC_VER) && !defined(__clang__)
+#define RADIO_TOOL_TARGET(x)
+#define RADIO_TOOL_UNROLL
+#define RADIO_TOOL_UNROLL_FULL
+#elif defined(__clang__)
+#define RADIO_TOOL_TARGET(x) __attribute__((target(x)))
+#define RADIO_TOOL_UNROLL _Pragma("unroll 4")
+#define RADIO_TOOL_UNROLL_FULL _Pragma("unroll")
+#else
+#define RADIO_TOOL_TARGET(x) __attribute__((target(x)))
+#define RADIO_TOOL_UNROLL _Pragma("GCC unroll 4")
+#define RADIO_TOOL_UNROLL_FULL _Pragma("GCC unroll 16")
+#endif
+
+namespace radio_tool::cpu
+{
+    /**
+     * Instruction set extensions available at runtime
+     */
+    class CPUFeatures
+    {
+    public:
+        bool sse2 = false;
+        bool ssse3 = false;
+        bool sse41 = false;
+        bool pclmul = false;
+        bool sha = false;
+        bool avx2 = false;
+        bool avx512f = false;
+        bool avx512bw = false;
+    };
+
+    /**
+     * Detect the features of the host CPU (cached after the first call)
+     * @note Always returns no features on non-x86 hosts
+     */
+    auto GetFeatures() -> const CPUFeatures &;
+} // namespace radio_tool::cpu
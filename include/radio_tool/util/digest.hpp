@@ -0,0 +1,70 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <array>
+#include <string>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace radio_tool::digest
+{
+    typedef std::array<uint8_t, 32> SHA256Digest;
+
+    /**
+     * CRC-32 (IEEE 802.3, same as zlib)
+     * @param crc CRC of the previous data, to continue a running CRC
+     */
+    auto CRC32(const uint8_t *data, const size_t &len, const uint32_t &crc = 0) -> uint32_t;
+
+    /**
+     * Running SHA-256 hash
+     */
+    class SHA256
+    {
+    public:
+        SHA256();
+
+        auto Update(const uint8_t *data, const size_t &len) -> void;
+
+        /**
+         * Pad the message and return the digest, the hash cannot be updated after this
+         */
+        auto Finalize() -> SHA256Digest;
+
+        /**
+         * Hash a buffer in one call
+         */
+        static auto Hash(const uint8_t *data, const size_t &len) -> SHA256Digest;
+
+    private:
+        std::array<uint32_t, 8> state;
+        std::array<uint8_t, 64> buffer;
+        uint64_t length;
+    };
+
+    /**
+     * Lower case hex string of a digest
+     */
+    auto ToHex(const SHA256Digest &digest) -> std::string;
+
+    /**
+     * Names of the CRC32/SHA-256 kernels selected for this CPU
+     */
+    auto GetKernelName() -> std::string;
+} // namespace radio_tool::digest
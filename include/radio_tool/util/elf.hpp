@@ -0,0 +1,76 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <radio_tool/util/span.hpp>
+#include <radio_tool/util/mapped_file.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace radio_tool::elf
+{
+    /**
+     * Loadable segment of an ELF file
+     */
+    class LoadSegment
+    {
+    public:
+        /**
+         * Physical (load) address, where the segment is stored in flash
+         */
+        uint32_t address;
+
+        /**
+         * Bytes from the file, a view of the mapped ELF
+         */
+        ByteView data;
+    };
+
+    /**
+     * Read only view of a 32-bit little endian ELF file (ARM Cortex-M firmware)
+     */
+    class ElfFile
+    {
+    public:
+        /**
+         * Map and parse the program headers of an ELF file
+         */
+        static auto Open(const std::string &file) -> ElfFile;
+
+        /**
+         * Tests if a file starts with the ELF magic
+         */
+        static auto IsElf(const ByteView &header) -> bool;
+
+        /**
+         * PT_LOAD segments with file data, in physical address order
+         * @note Segments without file data (.bss) are skipped
+         */
+        auto GetLoadSegments() const -> const std::vector<LoadSegment> &
+        {
+            return segments;
+        }
+
+    private:
+        std::shared_ptr<const MappedFile> file;
+        std::vector<LoadSegment> segments;
+    };
+} // namespace radio_tool::elf
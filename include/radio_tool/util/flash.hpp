@@ -17,6 +17,10 @@
  */
 #pragma once
 
+#include <radio_tool/util/span.hpp>
+
+#include <set>
+#include <map>
 #include <vector>
 #include <optional>
 #include <iomanip>
@@ -135,6 +139,73 @@ namespace radio_tool::flash
                 }
             }
         }
+
+        /**
+         * If every byte of [start, end) is inside the flash map
+         */
+        static auto InMap(const FlashMap &map, const uint32_t &start, const uint32_t &end) -> bool
+        {
+            auto covered = 0ull;
+            AlignedContiguousMemoryOp(map, start, end, [&covered](const uint32_t &, const uint32_t &size, const FlashSector &) {
+                covered += size;
+            });
+            return start <= end && covered == static_cast<uint64_t>(end - start);
+        }
+
+        /**
+         * Sectors which must be erased and written to turn the installed image into the next image
+         * <Address, Data> for each segment of an image
+         * @note A sector is unchanged only if both images place exactly the same bytes in it,
+         *       sectors not touched by the next image are never returned
+         */
+        static auto ChangedSectors(const FlashMap &map, const std::vector<std::pair<uint32_t, ByteView>> &installed,
+                                   const std::vector<std::pair<uint32_t, ByteView>> &next) -> std::set<uint16_t>
+        {
+            //split both images into per sector pieces
+            typedef std::map<uint16_t, std::vector<std::pair<uint32_t, ByteView>>> Pieces;
+            auto split = [&map](const std::vector<std::pair<uint32_t, ByteView>> &image) {
+                Pieces ret;
+                for (const auto &seg : image)
+                {
+                    AlignedContiguousMemoryOp(map, seg.first, seg.first + static_cast<uint32_t>(seg.second.size()),
+                        [&ret, &seg](const uint32_t &addr, const uint32_t &size, const FlashSector &sector) {
+                            ret[sector.index].push_back({addr, seg.second.Sub(addr - seg.first, size)});
+                        });
+                }
+                for (auto &p : ret)
+                {
+                    std::sort(p.second.begin(), p.second.end(), [](const auto &x, const auto &y) { return x.first < y.first; });
+                }
+                return ret;
+            };
+
+            auto a = split(installed), b = split(next);
+            std::set<uint16_t> ret;
+            for (const auto &sec : map)
+            {
+                auto pa = a.find(sec.index), pb = b.find(sec.index);
+                if (pb == b.end())
+                {
+                    continue; //not written by the next image
+                }
+                if (pa == a.end())
+                {
+                    ret.insert(sec.index);
+                    continue;
+                }
+
+                auto same = pa->second.size() == pb->second.size()
+                    && std::equal(pa->second.begin(), pa->second.end(), pb->second.begin(), [](const auto &x, const auto &y) {
+                        return x.first == y.first && x.second.size() == y.second.size()
+                            && std::equal(x.second.begin(), x.second.end(), y.second.begin());
+                    });
+                if (!same)
+                {
+                    ret.insert(sec.index);
+                }
+            }
+            return ret;
+        }
     };
 
     /**
@@ -0,0 +1,72 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <radio_tool/util/span.hpp>
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace radio_tool
+{
+    /**
+     * Collects the pieces of an output file and writes them with as few syscalls as possible
+     * @note Uses writev on POSIX, pieces added with Add must stay alive until Write
+     */
+    class GatherWriter
+    {
+    public:
+        /**
+         * Reference a buffer without copying it
+         */
+        auto Add(const ByteView &data) -> void;
+
+        /**
+         * Copy a small buffer (headers etc.)
+         */
+        auto AddCopy(const void *data, const size_t &len) -> void;
+
+        /**
+         * Add len bytes of value, 0x00/0xFF come from shared constant blocks
+         */
+        auto AddFill(const uint8_t &value, const size_t &len) -> void;
+
+        /**
+         * Total size of the output
+         */
+        auto GetSize() const -> uint64_t;
+
+        /**
+         * Write all pieces to a temp file and rename it over file
+         * @note file may be the source of a referenced mapping
+         */
+        auto Write(const std::string &file) const -> void;
+
+    private:
+        std::vector<ByteView> pieces;
+
+        /**
+         * Storage for AddCopy and uncommon fill values, a deque never moves its elements
+         */
+        std::deque<std::vector<uint8_t>> owned;
+
+        auto WritePieces(const std::string &file) const -> void;
+    };
+} // namespace radio_tool
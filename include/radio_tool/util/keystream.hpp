@@ -0,0 +1,147 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace radio_tool::keystream
+{
+    /**
+     * Buffers at least this large are split across the shared thread pool
+     */
+    constexpr size_t ParallelThreshold = 0x100000;
+
+    /**
+     * Limit the number of threads used for large buffers
+     * @param threads 0 = one per CPU core, 1 = always single threaded
+     */
+    auto SetThreadLimit(const unsigned &threads) -> void;
+
+    /**
+     * XOR a buffer with a repeating key
+     * @param key_offset The position inside the key period of the first byte of data
+     * @note Uses the widest vector unit available on this CPU (AVX-512/AVX2/SSE2), falls back to scalar code
+     */
+    auto Apply(uint8_t *data, const size_t &len, const uint8_t *key, const uint32_t &key_len, const uint32_t &key_offset = 0) -> void;
+
+    /**
+     * Sum the bytes of data XOR key without modifying data
+     * @note Used to checksum encrypted data in a single pass
+     */
+    auto Sum(const uint8_t *data, const size_t &len, const uint8_t *key, const uint32_t &key_len, const uint32_t &key_offset = 0) -> uint64_t;
+
+    class KernelSet;
+
+    /**
+     * XOR keystream which keeps track of its position, so large images can be
+     * encrypted/decrypted in small chunks
+     * @note The key is expanded once when the stream is created
+     * @remarks Chunks of ParallelThreshold or more are split into key period aligned
+     *          ranges and processed on the shared thread pool
+     */
+    class CipherStream
+    {
+    public:
+        /**
+         * @param offset The keystream position of the first byte passed to Apply/Sum
+         */
+        CipherStream(const uint8_t *key, const uint32_t &key_len, const uint64_t &offset = 0);
+
+        /**
+         * Create a stream for a key whose length is known at compile time,
+         * using kernels unrolled for that length with power of two wrapping
+         * @note Instantiated for 0x100 and 0x400 byte keys
+         */
+        template <uint32_t KeyLen>
+        static auto Fixed(const uint8_t *key, const uint64_t &offset = 0) -> CipherStream;
+
+        /**
+         * XOR the next chunk of the stream and advance the stream position
+         */
+        auto Apply(uint8_t *data, const size_t &len) -> void;
+
+        /**
+         * XOR a chunk at an explicit stream position, the running position is unchanged
+         */
+        auto ApplyAt(const uint64_t &at, uint8_t *data, const size_t &len) const -> void;
+
+        /**
+         * Sum the next chunk XOR key and advance the stream position
+         */
+        auto Sum(const uint8_t *data, const size_t &len) -> uint64_t;
+
+        /**
+         * Sum a chunk XOR key at an explicit stream position, the running position is unchanged
+         */
+        auto SumAt(const uint64_t &at, const uint8_t *data, const size_t &len) const -> uint64_t;
+
+        /**
+         * Move the stream to a new position
+         */
+        auto Seek(const uint64_t &at) -> void
+        {
+            offset = at;
+        }
+
+        /**
+         * The current stream position
+         */
+        auto GetOffset() const -> uint64_t
+        {
+            return offset;
+        }
+
+        /**
+         * The key used by this stream
+         */
+        auto GetKey() const -> const uint8_t *
+        {
+            return key;
+        }
+
+        /**
+         * The length of one key period
+         */
+        auto GetKeyLength() const -> uint32_t
+        {
+            return key_len;
+        }
+
+    private:
+        const uint8_t *key;
+        uint32_t key_len;
+        uint64_t offset;
+
+        /**
+         * Kernels selected for this key when the stream was created
+         */
+        const KernelSet *kernel;
+
+        /**
+         * The key repeated for two periods plus one vector
+         */
+        std::vector<uint8_t> ext;
+    };
+
+    /**
+     * Returns the name of the XOR kernel selected for this CPU
+     */
+    auto GetKernelName() -> const char *;
+} // namespace radio_tool::keystream
@@ -0,0 +1,68 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace radio_tool
+{
+    /**
+     * A read-only memory mapping of a whole file
+     * @note Falls back to reading the file into memory when mapping is not possible
+     */
+    class MappedFile
+    {
+    public:
+        ~MappedFile();
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        /**
+         * Map a file, throws if it cant be opened
+         */
+        static auto Open(const std::string &file) -> std::shared_ptr<const MappedFile>;
+
+        auto GetData() const -> const uint8_t * { return ptr; }
+        auto GetSize() const -> size_t { return len; }
+
+        /**
+         * If the file is mapped rather than copied into memory
+         */
+        auto IsMapped() const -> bool { return mapped; }
+
+    private:
+        MappedFile() = default;
+
+        const uint8_t *ptr = nullptr;
+        size_t len = 0;
+        bool mapped = false;
+
+        /**
+         * Copy of the file when it could not be mapped
+         */
+        std::vector<uint8_t> fallback;
+#ifdef _WIN32
+        void *file_handle = nullptr;
+        void *map_handle = nullptr;
+#endif
+    };
+} // namespace radio_tool
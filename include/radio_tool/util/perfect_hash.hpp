@@ -0,0 +1,108 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <array>
+#include <string_view>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace radio_tool::hash
+{
+    /**
+     * 32-bit FNV-1a hash
+     */
+    constexpr auto FNV1a(const std::string_view &str) -> uint32_t
+    {
+        uint32_t h = 0x811c9dc5;
+        for (const auto &c : str)
+        {
+            h = (h ^ static_cast<uint8_t>(c)) * 0x01000193;
+        }
+        return h;
+    }
+
+    /**
+     * Perfect hash of N integer keys, built at compile time
+     * 
+     * Keys are mixed with a seed which is searched for when the table is built so that
+     * every distinct key gets its own slot. Duplicate keys map to the first index.
+     * @note Find only returns an index if the key matches, callers of tables keyed by
+     *       a hash of a string should still compare the string
+     */
+    template <size_t N>
+    class PerfectHash
+    {
+    public:
+        static constexpr size_t Bits = N < 4 ? 3 : (N < 8 ? 4 : (N < 16 ? 5 : (N < 32 ? 6 : (N < 64 ? 7 : 8))));
+        static constexpr size_t Size = static_cast<size_t>(1) << Bits;
+        static constexpr uint8_t Empty = 0xff;
+        static_assert(N < Empty, "Too many keys for PerfectHash");
+
+        constexpr PerfectHash(const std::array<uint32_t, N> &keys)
+            : keys(keys), seed(0), slots()
+        {
+            for (seed = 1; !TryBuild(); seed++)
+            {
+            }
+        }
+
+        /**
+         * Index of key in the key list, or -1
+         */
+        constexpr auto Find(const uint32_t &key) const -> int
+        {
+            auto idx = slots[Slot(key, seed)];
+            return idx != Empty && keys[idx] == key ? idx : -1;
+        }
+
+    private:
+        std::array<uint32_t, N> keys;
+        uint32_t seed;
+        std::array<uint8_t, Size> slots;
+
+        static constexpr auto Slot(const uint32_t &key, const uint32_t &seed) -> size_t
+        {
+            auto h = (key ^ seed) * 0x9e3779b1u;
+            h ^= h >> 15;
+            h *= 0x85ebca6bu;
+            return (h >> (32 - Bits)) & (Size - 1);
+        }
+
+        constexpr auto TryBuild() -> bool
+        {
+            for (auto &s : slots)
+            {
+                s = Empty;
+            }
+            for (size_t x = 0; x < N; x++)
+            {
+                auto &s = slots[Slot(keys[x], seed)];
+                if (s == Empty)
+                {
+                    s = static_cast<uint8_t>(x);
+                }
+                else if (keys[s] != keys[x])
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+} // namespace radio_tool::hash
@@ -0,0 +1,70 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <utility>
+#include <stdexcept>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace radio_tool
+{
+    /**
+     * Non-owning view of contiguous memory (std::span is C++20)
+     */
+    template <typename T>
+    class Span
+    {
+    public:
+        constexpr Span() = default;
+        constexpr Span(T *ptr, const size_t &len)
+            : ptr(ptr), len(len) {}
+
+        /**
+         * View of any container with data()/size()
+         */
+        template <typename C, typename = decltype(std::declval<C &>().data())>
+        constexpr Span(C &c)
+            : ptr(c.data()), len(c.size()) {}
+
+        constexpr auto data() const -> T * { return ptr; }
+        constexpr auto size() const -> size_t { return len; }
+        constexpr auto empty() const -> bool { return len == 0; }
+        constexpr auto begin() const -> T * { return ptr; }
+        constexpr auto end() const -> T * { return ptr + len; }
+        constexpr auto operator[](const size_t &idx) const -> T & { return ptr[idx]; }
+
+        /**
+         * View of part of this view
+         */
+        auto Sub(const size_t &offset, const size_t &count) const -> Span<T>
+        {
+            if (offset > len || count > len - offset)
+            {
+                throw std::out_of_range("Span out of range");
+            }
+            return Span<T>(ptr + offset, count);
+        }
+
+    private:
+        T *ptr = nullptr;
+        size_t len = 0;
+    };
+
+    typedef Span<const uint8_t> ByteView;
+} // namespace radio_tool
@@ -0,0 +1,79 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+
+namespace radio_tool::thread
+{
+    /**
+     * Fixed size pool of worker threads
+     */
+    class ThreadPool
+    {
+    public:
+        /**
+         * @param threads Number of worker threads, 0 = one per CPU core
+         */
+        explicit ThreadPool(const unsigned &threads = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        /**
+         * Queue a task to run on the pool
+         */
+        auto Submit(std::function<void()> &&fn) -> std::future<void>;
+
+        /**
+         * Run fn(0..count-1) across the pool and wait for all of them to finish
+         * @note The calling thread also runs tasks, so this is safe to call from inside a pool task
+         * @remarks The first exception thrown by fn is rethrown once all tasks have finished
+         */
+        auto ParallelFor(const size_t &count, const std::function<void(const size_t &)> &fn) -> void;
+
+        /**
+         * Number of worker threads in this pool
+         */
+        auto GetThreadCount() const -> unsigned
+        {
+            return static_cast<unsigned>(workers.size());
+        }
+
+        /**
+         * Process wide pool with one thread per CPU core
+         */
+        static auto Shared() -> ThreadPool &;
+
+    private:
+        std::vector<std::thread> workers;
+        std::deque<std::packaged_task<void()>> queue;
+        std::mutex lock;
+        std::condition_variable signal;
+        bool stop;
+
+        auto Worker() -> void;
+    };
+} // namespace radio_tool::thread
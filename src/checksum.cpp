@@ -0,0 +1,427 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <radio_tool/util/checksum.hpp>
+#include <radio_tool/util/cpu.hpp>
+
+#include <algorithm>
+
+#ifdef RADIO_TOOL_X86
+#include <immintrin.h>
+#endif
+
+using namespace radio_tool::checksum;
+
+namespace
+{
+    /**
+     * Kernels only handle the bulk of the data, they return raw (unreduced) sums
+     * so the public functions can apply the modulo/folding once
+     */
+    typedef uint64_t (*SumKernel)(const uint8_t *data, size_t len);
+    typedef void (*FletcherKernel)(const uint8_t *data, size_t len, uint32_t &c0, uint32_t &c1);
+    typedef uint64_t (*WordSumKernel)(const uint8_t *data, size_t len);
+
+    class KernelSet
+    {
+    public:
+        const char *name;
+        SumKernel sum;
+        FletcherKernel fletcher16;
+        WordSumKernel word_sum;
+    };
+
+    /**
+     * Bytes per Fletcher16 vector block, the lane sums cannot overflow
+     * before the delayed modulo at the end of each block
+     */
+    constexpr auto FletcherBlock = 0x1000u;
+
+    /**
+     * Largest block with no 32bit overflow in the scalar Fletcher16 loop:
+     * n > 0 and n * (n+1) / 2 * (2^8-1) < (2^32-1)
+     */
+    constexpr auto FletcherScalarBlock = 5802u;
+
+    /**
+     * 16bit words summed into 32bit lanes before widening
+     */
+    constexpr auto WordSumBlock = 0x10000u;
+
+    auto SumScalar(const uint8_t *data, size_t len) -> uint64_t
+    {
+        uint64_t ret = 0;
+        for (size_t i = 0; i < len; i++)
+        {
+            ret += data[i];
+        }
+        return ret;
+    }
+
+    auto Fletcher16Scalar(const uint8_t *data, size_t len, uint32_t &c0, uint32_t &c1) -> void
+    {
+        while (len > 0)
+        {
+            auto block = std::min<size_t>(len, FletcherScalarBlock);
+            for (size_t i = 0; i < block; i++)
+            {
+                c0 += data[i];
+                c1 += c0;
+            }
+            c0 %= 255;
+            c1 %= 255;
+            data += block;
+            len -= block;
+        }
+    }
+
+    /**
+     * Sum of little endian 16bit words, len must be even
+     */
+    auto WordSumScalar(const uint8_t *data, size_t len) -> uint64_t
+    {
+        uint64_t ret = 0;
+        for (size_t i = 0; i + 1 < len; i += 2)
+        {
+            ret += data[i] | (data[i + 1] << 8);
+        }
+        return ret;
+    }
+
+#ifdef RADIO_TOOL_X86
+    RADIO_TOOL_TARGET("sse2")
+    auto SumSSE2(const uint8_t *data, size_t len) -> uint64_t
+    {
+        size_t i = 0;
+        auto zero = _mm_setzero_si128();
+        auto acc = _mm_setzero_si128();
+        RADIO_TOOL_UNROLL
+        for (; i + sizeof(__m128i) <= len; i += sizeof(__m128i))
+        {
+            auto a = _mm_loadu_si128((const __m128i *)(data + i));
+            acc = _mm_add_epi64(acc, _mm_sad_epu8(a, zero));
+        }
+        uint64_t lanes[2];
+        _mm_storeu_si128((__m128i *)lanes, acc);
+        return lanes[0] + lanes[1] + SumScalar(data + i, len - i);
+    }
+
+    /**
+     * Per 16 byte chunk: c1 += 16 * c0 + sum((16 - i) * b[i]), c0 += sum(b[i])
+     */
+    RADIO_TOOL_TARGET("sse2")
+    auto Fletcher16SSE2(const uint8_t *data, size_t len, uint32_t &c0, uint32_t &c1) -> void
+    {
+        constexpr auto n = sizeof(__m128i);
+        auto zero = _mm_setzero_si128();
+        auto w_lo = _mm_setr_epi16(16, 15, 14, 13, 12, 11, 10, 9);
+        auto w_hi = _mm_setr_epi16(8, 7, 6, 5, 4, 3, 2, 1);
+
+        while (len >= n)
+        {
+            auto block = std::min<size_t>(len, FletcherBlock) & ~(n - 1);
+            auto v_s1 = _mm_setzero_si128();
+            auto v_ps = _mm_setzero_si128();
+            auto v_s2 = _mm_setzero_si128();
+            for (size_t i = 0; i < block; i += n)
+            {
+                auto b = _mm_loadu_si128((const __m128i *)(data + i));
+                v_ps = _mm_add_epi32(v_ps, v_s1);
+                v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(b, zero));
+                v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(_mm_unpacklo_epi8(b, zero), w_lo));
+                v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(_mm_unpackhi_epi8(b, zero), w_hi));
+            }
+
+            uint32_t s1[4], ps[4], s2[4];
+            _mm_storeu_si128((__m128i *)s1, v_s1);
+            _mm_storeu_si128((__m128i *)ps, v_ps);
+            _mm_storeu_si128((__m128i *)s2, v_s2);
+            uint64_t t1 = 0, tp = 0, t2 = 0;
+            for (auto x = 0; x < 4; x++)
+            {
+                t1 += s1[x];
+                tp += ps[x];
+                t2 += s2[x];
+            }
+            c1 = (c1 + (block * c0) + (n * tp) + t2) % 255;
+            c0 = (c0 + t1) % 255;
+
+            data += block;
+            len -= block;
+        }
+        Fletcher16Scalar(data, len, c0, c1);
+    }
+
+    RADIO_TOOL_TARGET("sse2")
+    auto WordSumSSE2(const uint8_t *data, size_t len) -> uint64_t
+    {
+        uint64_t ret = 0;
+        auto zero = _mm_setzero_si128();
+        size_t i = 0;
+        while (i + sizeof(__m128i) <= len)
+        {
+            auto acc = _mm_setzero_si128();
+            auto end = std::min<size_t>(len, i + WordSumBlock) - sizeof(__m128i);
+            for (; i <= end; i += sizeof(__m128i))
+            {
+                auto a = _mm_loadu_si128((const __m128i *)(data + i));
+                acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(a, zero));
+                acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(a, zero));
+            }
+            uint32_t lanes[4];
+            _mm_storeu_si128((__m128i *)lanes, acc);
+            ret += (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        }
+        return ret + WordSumScalar(data + i, len - i);
+    }
+
+    RADIO_TOOL_TARGET("avx2")
+    auto SumAVX2(const uint8_t *data, size_t len) -> uint64_t
+    {
+        size_t i = 0;
+        auto zero = _mm256_setzero_si256();
+        auto acc = _mm256_setzero_si256();
+        RADIO_TOOL_UNROLL
+        for (; i + sizeof(__m256i) <= len; i += sizeof(__m256i))
+        {
+            auto a = _mm256_loadu_si256((const __m256i *)(data + i));
+            acc = _mm256_add_epi64(acc, _mm256_sad_epu8(a, zero));
+        }
+        uint64_t lanes[4];
+        _mm256_storeu_si256((__m256i *)lanes, acc);
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3] + SumScalar(data + i, len - i);
+    }
+
+    /**
+     * Per 32 byte chunk: c1 += 32 * c0 + sum((32 - i) * b[i]), c0 += sum(b[i])
+     */
+    RADIO_TOOL_TARGET("avx2")
+    auto Fletcher16AVX2(const uint8_t *data, size_t len, uint32_t &c0, uint32_t &c1) -> void
+    {
+        constexpr auto n = sizeof(__m256i);
+        auto zero = _mm256_setzero_si256();
+        auto ones = _mm256_set1_epi16(1);
+        auto weights = _mm256_setr_epi8(
+            32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+            16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+
+        while (len >= n)
+        {
+            auto block = std::min<size_t>(len, FletcherBlock) & ~(n - 1);
+            auto v_s1 = _mm256_setzero_si256();
+            auto v_ps = _mm256_setzero_si256();
+            auto v_s2 = _mm256_setzero_si256();
+            for (size_t i = 0; i < block; i += n)
+            {
+                auto b = _mm256_loadu_si256((const __m256i *)(data + i));
+                v_ps = _mm256_add_epi32(v_ps, v_s1);
+                v_s1 = _mm256_add_epi32(v_s1, _mm256_sad_epu8(b, zero));
+                v_s2 = _mm256_add_epi32(v_s2, _mm256_madd_epi16(_mm256_maddubs_epi16(b, weights), ones));
+            }
+
+            uint32_t s1[8], ps[8], s2[8];
+            _mm256_storeu_si256((__m256i *)s1, v_s1);
+            _mm256_storeu_si256((__m256i *)ps, v_ps);
+            _mm256_storeu_si256((__m256i *)s2, v_s2);
+            uint64_t t1 = 0, tp = 0, t2 = 0;
+            for (auto x = 0; x < 8; x++)
+            {
+                t1 += s1[x];
+                tp += ps[x];
+                t2 += s2[x];
+            }
+            c1 = (c1 + (block * c0) + (n * tp) + t2) % 255;
+            c0 = (c0 + t1) % 255;
+
+            data += block;
+            len -= block;
+        }
+        Fletcher16Scalar(data, len, c0, c1);
+    }
+
+    RADIO_TOOL_TARGET("avx2")
+    auto WordSumAVX2(const uint8_t *data, size_t len) -> uint64_t
+    {
+        uint64_t ret = 0;
+        auto zero = _mm256_setzero_si256();
+        size_t i = 0;
+        while (i + sizeof(__m256i) <= len)
+        {
+            auto acc = _mm256_setzero_si256();
+            auto end = std::min<size_t>(len, i + WordSumBlock) - sizeof(__m256i);
+            for (; i <= end; i += sizeof(__m256i))
+            {
+                auto a = _mm256_loadu_si256((const __m256i *)(data + i));
+                acc = _mm256_add_epi32(acc, _mm256_unpacklo_epi16(a, zero));
+                acc = _mm256_add_epi32(acc, _mm256_unpackhi_epi16(a, zero));
+            }
+            uint32_t lanes[8];
+            _mm256_storeu_si256((__m256i *)lanes, acc);
+            for (auto x = 0; x < 8; x++)
+            {
+                ret += lanes[x];
+            }
+        }
+        return ret + WordSumScalar(data + i, len - i);
+    }
+#endif
+
+    auto SelectKernel() -> KernelSet
+    {
+#ifdef RADIO_TOOL_X86
+        const auto &cpu = radio_tool::cpu::GetFeatures();
+        if (cpu.avx2)
+        {
+            return {"avx2", SumAVX2, Fletcher16AVX2, WordSumAVX2};
+        }
+        if (cpu.sse2)
+        {
+            return {"sse2", SumSSE2, Fletcher16SSE2, WordSumSSE2};
+        }
+#endif
+        return {"scalar", SumScalar, Fletcher16Scalar, WordSumScalar};
+    }
+
+    auto GetKernel() -> const KernelSet &
+    {
+        static const auto kernel = SelectKernel();
+        return kernel;
+    }
+} // namespace
+
+auto radio_tool::checksum::Sum(const uint8_t *data, const size_t &len) -> uint64_t
+{
+    return GetKernel().sum(data, len);
+}
+
+auto radio_tool::checksum::Fletcher16(const uint8_t *data, const size_t &len) -> uint16_t
+{
+    Fletcher16State s;
+    s.Update(data, len);
+    return s.Finalize();
+}
+
+auto radio_tool::checksum::Internet(const uint8_t *data, const size_t &len) -> uint16_t
+{
+    InternetState s;
+    s.Update(data, len);
+    return s.Finalize();
+}
+
+auto radio_tool::checksum::BSD(const uint8_t *data, const size_t &len) -> uint16_t
+{
+    BSDState s;
+    s.Update(data, len);
+    return s.Finalize();
+}
+
+auto CSState::Update(const uint8_t *data, const size_t &len) -> void
+{
+    sum += GetKernel().sum(data, len);
+    length += len;
+}
+
+auto CSState::Combine(const CSState &other) -> void
+{
+    sum += other.sum;
+    length += other.length;
+}
+
+auto CSState::Finalize() const -> uint16_t
+{
+    return FromSum(static_cast<uint16_t>(sum));
+}
+
+auto Fletcher16State::Update(const uint8_t *data, const size_t &len) -> void
+{
+    GetKernel().fletcher16(data, len, c0, c1);
+    length += len;
+}
+
+auto Fletcher16State::Combine(const Fletcher16State &other) -> void
+{
+    c1 = (c1 + (other.length % 255) * c0 + other.c1) % 255;
+    c0 = (c0 + other.c0) % 255;
+    length += other.length;
+}
+
+auto Fletcher16State::Finalize() const -> uint16_t
+{
+    return static_cast<uint16_t>((c1 << 8) | c0);
+}
+
+auto InternetState::Add(uint64_t s, const bool &swap) -> void
+{
+    while (s >> 16)
+    {
+        s = (s & 0xffff) + (s >> 16);
+    }
+    sum += swap ? ((s & 0xff) << 8) | (s >> 8) : s;
+}
+
+auto InternetState::Update(const uint8_t *data, const size_t &len) -> void
+{
+    //ones complement sum is byte order independent, sum little endian words and swap at the end
+    auto s = GetKernel().word_sum(data, len & ~size_t(1));
+    if (len & 1)
+    {
+        s += data[len - 1];
+    }
+
+    //data starting on an odd byte has its words shifted by one byte
+    Add(s, length & 1);
+    length += len;
+}
+
+auto InternetState::Combine(const InternetState &other) -> void
+{
+    Add(other.sum, length & 1);
+    length += other.length;
+}
+
+auto InternetState::Finalize() const -> uint16_t
+{
+    auto s = sum;
+    while (s >> 16)
+    {
+        s = (s & 0xffff) + (s >> 16);
+    }
+
+    auto be = static_cast<uint16_t>(((s & 0xff) << 8) | (s >> 8));
+    return static_cast<uint16_t>(~be);
+}
+
+auto BSDState::Update(const uint8_t *data, const size_t &len) -> void
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        checksum = (checksum >> 1) + ((checksum & 1) << 15);
+        checksum += data[i];
+        checksum &= 0xffff;
+    }
+    length += len;
+}
+
+auto BSDState::Finalize() const -> uint16_t
+{
+    return static_cast<uint16_t>(checksum);
+}
+
+auto radio_tool::checksum::GetKernelName() -> const char *
+{
+    return GetKernel().name;
+}
@@ -0,0 +1,146 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <radio_tool/fw/cipher/detect.hpp>
+#include <radio_tool/fw/xor_tool.hpp>
+#include <radio_tool/util/thread_pool.hpp>
+
+#include <algorithm>
+
+using namespace radio_tool::fw::cipher;
+
+/**
+ * STM32F40X vector table size (16 core + 82 interrupt vectors)
+ */
+constexpr auto VectorTableSampleSize = 0x188u;
+
+auto CipherDetect::MakeSamples(const uint8_t *data, const size_t &len, const uint32_t &key_offset) -> std::vector<DetectSample>
+{
+    std::vector<DetectSample> ret;
+    if (len >= VectorTableSampleSize)
+    {
+        ret.push_back({SampleType::VectorTable, key_offset, std::vector<uint8_t>(data, data + VectorTableSampleSize)});
+    }
+    auto tail = std::min<size_t>(len, PaddingSampleSize);
+    if (tail > 0)
+    {
+        auto start = len - tail;
+        ret.push_back({SampleType::Padding, static_cast<uint32_t>(key_offset + start), std::vector<uint8_t>(data + start, data + len)});
+    }
+    return ret;
+}
+
+auto CipherDetect::MakeSamples(const FirmwareSupport &fw) -> std::vector<DetectSample>
+{
+    std::vector<DetectSample> ret;
+    const auto &data = fw.GetData();
+    auto r_offset = 0u;
+    for (const auto &r : fw.GetMemoryRanges())
+    {
+        if (r_offset + r.second > data.size())
+        {
+            break;
+        }
+        auto s = MakeSamples(data.data() + r_offset, r.second, r_offset);
+        std::move(s.begin(), s.end(), std::back_inserter(ret));
+        r_offset += r.second;
+    }
+    return ret;
+}
+
+auto CipherDetect::Score(const std::vector<DetectSample> &samples, const CipherInfo &cipher) -> double
+{
+    auto vt = 0.0, pad = 0.0;
+    auto n_vt = 0u, n_pad = 0u;
+    std::vector<uint8_t> buf;
+    for (const auto &s : samples)
+    {
+        buf = s.data;
+        keystream::Apply(buf.data(), buf.size(), cipher.key, cipher.length, s.key_offset);
+        switch (s.type)
+        {
+        case SampleType::VectorTable:
+            vt += XORTool::ScoreVectorTable(buf.data(), buf.size());
+            n_vt++;
+            break;
+        case SampleType::Padding:
+        {
+            //a wrong key leaves ~2/256 of the bytes looking like fill
+            auto fill = std::count_if(buf.begin(), buf.end(), [](const uint8_t &b) { return b == 0xff || b == 0x00; });
+            pad += fill / (double)buf.size();
+            n_pad++;
+            break;
+        }
+        }
+    }
+
+    //each kind of sample has the same weight
+    auto kinds = (n_vt > 0 ? 1 : 0) + (n_pad > 0 ? 1 : 0);
+    if (kinds == 0)
+    {
+        return 0.0;
+    }
+    return ((n_vt > 0 ? vt / n_vt : 0.0) + (n_pad > 0 ? pad / n_pad : 0.0)) / kinds;
+}
+
+auto CipherDetect::Rank(const std::vector<DetectSample> &samples, const std::vector<CipherKey> &candidates) -> std::vector<DetectResult>
+{
+    std::vector<DetectResult> ret;
+    if (candidates.empty())
+    {
+        for (const auto &c : AllCiphers)
+        {
+            ret.push_back({&c, 0.0, 0.0});
+        }
+    }
+    else
+    {
+        for (const auto &c : candidates)
+        {
+            ret.push_back({&GetCipherInfo(c), 0.0, 0.0});
+        }
+    }
+
+    radio_tool::thread::ThreadPool::Shared().ParallelFor(ret.size(), [&](const size_t &idx) {
+        ret[idx].score = Score(samples, *ret[idx].cipher);
+    });
+
+    auto total = 0.0;
+    for (const auto &r : ret)
+    {
+        total += r.score;
+    }
+    for (auto &r : ret)
+    {
+        r.confidence = total > 0 ? r.score / total : 0.0;
+    }
+
+    std::stable_sort(ret.begin(), ret.end(), [](const DetectResult &a, const DetectResult &b) {
+        return a.score > b.score;
+    });
+    return ret;
+}
+
+auto CipherDetect::Detect(const std::vector<DetectSample> &samples, const std::vector<CipherKey> &candidates) -> std::optional<DetectResult>
+{
+    auto rank = Rank(samples, candidates);
+    if (!rank.empty() && rank[0].score >= MinScore && rank[0].confidence >= MinConfidence)
+    {
+        return rank[0];
+    }
+    return {};
+}
@@ -0,0 +1,83 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <radio_tool/util/cpu.hpp>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#define RADIO_TOOL_CPUID_MSVC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#define RADIO_TOOL_CPUID_GNU
+#endif
+
+using namespace radio_tool::cpu;
+
+static auto DetectFeatures() -> CPUFeatures
+{
+    CPUFeatures ret;
+#if defined(RADIO_TOOL_CPUID_GNU)
+    __builtin_cpu_init();
+    ret.sse2 = __builtin_cpu_supports("sse2");
+    ret.ssse3 = __builtin_cpu_supports("ssse3");
+    ret.sse41 = __builtin_cpu_supports("sse4.1");
+    ret.pclmul = __builtin_cpu_supports("pclmul");
+    ret.avx2 = __builtin_cpu_supports("avx2");
+    ret.avx512f = __builtin_cpu_supports("avx512f");
+    ret.avx512bw = __builtin_cpu_supports("avx512bw");
+
+    //older compilers dont know "sha", read it from cpuid leaf 7
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+    {
+        ret.sha = (ebx & (1 << 29)) != 0;
+    }
+#elif defined(RADIO_TOOL_CPUID_MSVC)
+    int info[4] = {};
+    __cpuid(info, 0);
+    auto max_leaf = info[0];
+
+    __cpuid(info, 1);
+    ret.sse2 = (info[3] & (1 << 26)) != 0;
+    ret.ssse3 = (info[2] & (1 << 9)) != 0;
+    ret.sse41 = (info[2] & (1 << 19)) != 0;
+    ret.pclmul = (info[2] & (1 << 1)) != 0;
+
+    //AVX state must also be enabled by the OS (OSXSAVE + XCR0)
+    auto os_xsave = (info[2] & (1 << 27)) != 0;
+    auto xcr0 = os_xsave ? _xgetbv(0) : 0;
+    auto os_avx = (xcr0 & 0x06) == 0x06;
+    auto os_avx512 = (xcr0 & 0xe6) == 0xe6;
+
+    if (max_leaf >= 7)
+    {
+        __cpuidex(info, 7, 0);
+        ret.avx2 = os_avx && (info[1] & (1 << 5)) != 0;
+        ret.avx512f = os_avx512 && (info[1] & (1 << 16)) != 0;
+        ret.avx512bw = os_avx512 && (info[1] & (1 << 30)) != 0;
+        ret.sha = (info[1] & (1 << 29)) != 0;
+    }
+#endif
+    return ret;
+}
+
+auto radio_tool::cpu::GetFeatures() -> const CPUFeatures &
+{
+    static const auto features = DetectFeatures();
+    return features;
+}
@@ -19,61 +19,69 @@
  * https://github.com/KG5RKI/CSFWTOOL
  */
 #include <radio_tool/fw/cs_fw.hpp>
-#include <radio_tool/fw/cipher/cs800.hpp>
-#include <radio_tool/fw/cipher/dr5xx0.hpp>
+#include <radio_tool/fw/cipher/cipher.hpp>
+#include <radio_tool/fw/cipher/detect.hpp>
 #include <radio_tool/util.hpp>
+#include <radio_tool/util/gather_writer.hpp>
 
 #include <fstream>
+#include <iostream>
 #include <sstream>
+#include <cstring>
 #include <iomanip>
 #include <iterator>
 
 using namespace radio_tool::fw;
 
+/**
+ * Size of the blocks used to read/write and checksum the image
+ */
+constexpr auto ChunkSize = 0x10000u;
+
 auto CSFW::Read(const std::string &fw) -> void
 {
-    std::ifstream in_file(fw, std::ios_base::binary);
-    if(in_file.is_open())
-    {
-        in_file.seekg(0, std::fstream::end);
-        auto len = in_file.tellg();
-        in_file.seekg(0, std::fstream::beg);
+    auto file = MappedFile::Open(fw);
+    ReadHeader(ByteView(file->GetData(), std::min<uint64_t>(file->GetSize(), sizeof(CS800D_header))), file->GetSize());
 
-        in_file.read((char*)&header, sizeof(CS800D_header));
+    //reference the image in place, pages are only read when used
+    data.Map(file, sizeof(CS800D_header), header.imagesize);
+    InvalidateCache();
 
-        //test file size is correct
-        if(header.imagesize == 0)
-        {
-            throw std::runtime_error("Invalid firmware file");
-        }
-        if(header.imagesize + header.imageHeaderSize + sizeof(uint16_t) != len)
-        {
-            throw std::runtime_error("Invalid firmware header");
-        }
+    uint16_t stored;
+    memcpy(&stored, file->GetData() + sizeof(CS800D_header) + header.imagesize, sizeof(uint16_t));
 
-        data.resize(header.imagesize);
-        in_file.read((char*)data.data(), header.imagesize);
-        in_file.read((char*)&checksum, sizeof(uint16_t));
-        in_file.close();
-
-        //xor checksum
-        ((uint8_t*)&checksum)[0] = ((uint8_t*)&checksum)[0] ^ cipher::cs800_0[header.imagesize % cipher::cs800_length];
-        ((uint8_t*)&checksum)[1] = ((uint8_t*)&checksum)[1] ^ cipher::cs800_0[(header.imagesize + 1) % cipher::cs800_length];
-
-        memory_ranges.push_back({header.baseaddr_offset, header.imagesize});
+    //samples pick the key, only that key is checked against the whole image
+    auto keys = RankCiphers(data.data(), header.imagesize);
+    for(auto x = 0u; x < keys.size(); x++)
+    {
+        cipherKey = keys[x];
 
-        //test checksum
-        auto cs_check = MakeChecksum();
-        if(cs_check != checksum)
+        //xor checksum, it is encrypted as the bytes following the image
+        checksum = stored;
+        GetCipher().ApplyAt(header.imagesize, (uint8_t*)&checksum, sizeof(checksum));
+        if(ImageChecksum() == checksum)
         {
-            //checksum not working right now
-            throw std::runtime_error("Invalid checksum");
+            if(x > 0)
+            {
+                std::cerr << "Cipher detection picked " << cipher::GetCipherInfo(keys[0]).name
+                          << " but the checksum matches " << cipher::GetCipherInfo(cipherKey).name << std::endl;
+            }
+            return;
         }
     }
-    else 
+    throw std::runtime_error("Invalid checksum");
+}
+
+auto CSFW::ReadHeader(const ByteView &buf, const uint64_t &file_size) -> void
+{
+    if(!SupportsFirmwareFile(buf, file_size))
     {
-        throw std::runtime_error("Cant open file");
+        throw std::runtime_error("Invalid firmware file");
     }
+
+    memcpy(&header, buf.data(), sizeof(CS800D_header));
+    memory_ranges = {{header.baseaddr_offset, header.imagesize}};
+    InvalidateCache();
 }
 
 auto CSFW::UpdateHeader() -> void
@@ -82,7 +90,7 @@ auto CSFW::UpdateHeader() -> void
     {
         throw std::runtime_error("CS Firmware can only contain one segment!");
     }
-    header.imagesize = data.size();
+    header.imagesize = GetImageSize();
     header.imageHeaderSize = sizeof(CS800D_header);
     header.version = 1;
     if(memory_ranges.size())
@@ -93,24 +101,46 @@ auto CSFW::UpdateHeader() -> void
 
 auto CSFW::Write(const std::string &fw) -> void
 {
-    std::ofstream of(fw, std::ios_base::binary);
-    if(of.is_open())
-    {
-        UpdateHeader();
-        auto data = MakeFiledata();
-        of.write((char*)data.data(), data.size());
+    UpdateHeader();
 
-        //Apply XOR to make checksum
-        ApplyXOR(data.begin() + header.imageHeaderSize, data.end(), cipher::cs800_0, cipher::cs800_length);
-        auto cs = CSChecksum(data.begin(), data.end());
+    //the trailing checksum covers the decrypted image, sum it before writing anything
+    auto cs = ImageChecksum();
 
-        //XOR the checksum before writing
-        ((uint8_t*)&cs)[0] = ((uint8_t*)&cs)[0] ^ cipher::cs800_0[header.imagesize % cipher::cs800_length];
-        ((uint8_t*)&cs)[1] = ((uint8_t*)&cs)[1] ^ cipher::cs800_0[(header.imagesize + 1) % cipher::cs800_length];
+    //XOR the checksum before writing
+    GetCipher().ApplyAt(header.imagesize, (uint8_t*)&cs, sizeof(cs));
 
-        of.write((char*)&cs, sizeof(cs));
+    GatherWriter out;
+    out.AddCopy(&header, sizeof(CS800D_header));
+    out.Add(ByteView(data.data(), header.imagesize));
+    out.AddCopy(&cs, sizeof(cs));
+    out.Write(fw);
+}
 
-        of.close();
+auto CSFW::WriteSegments(const std::string &fw, const std::vector<std::pair<uint32_t, std::string>> &segments) -> void
+{
+    PlanSegments(segments);
+    UpdateHeader();
+
+    std::ofstream out(fw, std::ios_base::binary);
+    if(!out.is_open())
+    {
+        throw std::runtime_error("Cant open file");
+    }
+    out.write((char*)&header, sizeof(CS800D_header));
+
+    //sum the plaintext as it goes past, the checksum is only needed at the end
+    auto state = HeaderChecksum();
+    StreamSegments(out, segments, [&state](const uint8_t *chunk, const size_t &len) {
+        state.Update(chunk, len);
+    });
+    auto cs = state.Finalize();
+
+    //XOR the checksum before writing
+    GetCipher().ApplyAt(header.imagesize, (uint8_t*)&cs, sizeof(cs));
+    out.write((char*)&cs, sizeof(cs));
+    if(!out)
+    {
+        throw std::runtime_error("Failed to write file");
     }
 }
 
@@ -120,9 +150,20 @@ auto CSFW::ToString() const -> std::string
 
     out << "== Connect Systems Firmware ==" << std::endl
         << "Image Size: " << std::fixed << std::setprecision(2) << (header.imagesize / 1024.0) << " KiB" << std::endl
-        << "Version:    " << header.version << std::endl
-        << "Checksum:   0x" << std::setw(4) << std::setfill('0') << std::hex << checksum << std::endl
-        << "Data Segments: " << std::endl;
+        << "Version:    " << header.version << std::endl;
+
+    //cipher and checksum are only known after reading the image
+    if(!data.empty())
+    {
+        out << "Cipher:     " << cipher::GetCipherInfo(cipherKey).name << std::endl
+            << "Checksum:   0x" << std::setw(4) << std::setfill('0') << std::hex << checksum << std::endl;
+    }
+    else
+    {
+        out << "Cipher:     not detected (use --digest)" << std::endl
+            << "Checksum:   not verified (use --digest)" << std::endl;
+    }
+    out << "Data Segments: " << std::endl;
 
     auto n = 0u;
     for (const auto &m : memory_ranges)
@@ -149,42 +190,64 @@ auto CSFW::SetRadioModel(const std::string&) -> void
 
 auto CSFW::Decrypt() -> void
 {
-    //dont know how to detect dr5xx0 so just use cs800 cipher always
-    ApplyXOR(data, cipher::cs800_0, cipher::cs800_length);
+    auto &buf = data.Mutable();
+    GetCipher().Apply(buf.data(), buf.size());
+    InvalidateCache();
 }
 
 auto CSFW::Encrypt() -> void
 {
-    //dont know how to detect dr5xx0 so just use cs800 cipher always
-    ApplyXOR(data, cipher::cs800_0, cipher::cs800_length);
+    auto &buf = data.Mutable();
+    GetCipher().Apply(buf.data(), buf.size());
+    InvalidateCache();
 }
 
-auto CSFW::SupportsFirmwareFile(const std::string &file) -> bool
+auto CSFW::GetCipher() const -> keystream::CipherStream
 {
-    std::ifstream in_file(file, std::ios_base::binary);
-    if(in_file.is_open())
+    return cipher::GetCipherInfo(cipherKey).make(0);
+}
+
+auto CSFW::RankCiphers(const uint8_t *image, const uint32_t &len) -> std::vector<cipher::CipherKey>
+{
+    auto samples = cipher::CipherDetect::MakeSamples(image, len);
+
+    std::vector<cipher::CipherKey> ret;
+    for(const auto &r : cipher::CipherDetect::Rank(samples, {cipher::CipherKey::CS800_0, cipher::CipherKey::CS800_1, cipher::CipherKey::DR5XX0}))
     {
-        CS800D_header header = {};
-        in_file.read((char*)&header, sizeof(CS800D_header));
-        in_file.seekg(0, std::ios_base::end);
-        auto len = in_file.tellg();
-        in_file.close();
+        ret.push_back(r.cipher->id);
+    }
+    return ret;
+}
 
-        //test is not resource file
-        if(header.imagesize == 0)
-        {
-            return false;
-        }
+auto CSFW::SupportsFirmwareFile(const ByteView &buf, const uint64_t &file_size) -> bool
+{
+    if(buf.size() < sizeof(CS800D_header))
+    {
+        return false;
+    }
 
-        //test image size matches
-        if(header.imagesize + header.imageHeaderSize + sizeof(uint16_t) != len)
-        {
-            return false;
-        }
+    CS800D_header header = {};
+    memcpy(&header, buf.data(), sizeof(CS800D_header));
 
-        return true;
+    //test is not resource file
+    if(header.imagesize == 0)
+    {
+        return false;
     }
-    return false;
+
+    //the image always follows the header directly, the checksum is read from right after it
+    if(header.imageHeaderSize != sizeof(CS800D_header))
+    {
+        return false;
+    }
+
+    //test image size matches
+    if((uint64_t)header.imagesize + header.imageHeaderSize + sizeof(uint16_t) != file_size)
+    {
+        return false;
+    }
+
+    return true;
 }
 
 auto CSFW::SupportsRadioModel(const std::string &model) -> bool
@@ -197,25 +260,22 @@ auto CSFW::SupportsRadioModel(const std::string &model) -> bool
     return false;
 }
 
-auto CSFW::MakeChecksum() const -> const uint16_t
+auto CSFW::ImageChecksum() const -> uint16_t
 {
-    //Make a copy of the firmware data because we will apply XOR
-    auto to_check = MakeFiledata();
-    
-    //XOR firmware data
-    ApplyXOR(to_check.begin() + header.imageHeaderSize, to_check.end(), cipher::cs800_0, cipher::cs800_length);
-
-    return CSChecksum(to_check.begin(), to_check.end());
+    //sum the decrypted image straight from the (mapped) encrypted data
+    auto cipher = GetCipher();
+    auto state = HeaderChecksum();
+    for(auto offset = 0u; offset < header.imagesize; offset += ChunkSize)
+    {
+        auto n = std::min(ChunkSize, header.imagesize - offset);
+        state.Combine(radio_tool::checksum::CSState(cipher.Sum(data.data() + offset, n), n));
+    }
+    return state.Finalize();
 }
 
-auto CSFW::MakeFiledata() const -> std::vector<uint8_t>
+auto CSFW::HeaderChecksum() const -> radio_tool::checksum::CSState
 {
-    auto h_ptr = (uint8_t*)&header;
-    std::vector<uint8_t> ret;
-    ret.reserve(header.imageHeaderSize + header.imagesize);
-
-    std::copy(h_ptr, h_ptr + sizeof(CS800D_header), std::back_inserter(ret));
-    std::copy(data.begin(), data.end(), std::back_inserter(ret));
-
+    radio_tool::checksum::CSState ret;
+    ret.Update((const uint8_t*)&header, sizeof(CS800D_header));
     return ret;
 }
\ No newline at end of file
@@ -191,4 +191,20 @@ auto DFU::InitUpload() const -> void
         }
         }
     }
-}
\ No newline at end of file
+}
+auto DFU::GetSerialNumber() const -> std::string
+{
+    libusb_device_descriptor desc;
+    if (libusb_get_device_descriptor(libusb_get_device(device), &desc) != LIBUSB_SUCCESS || desc.iSerialNumber == 0)
+    {
+        return std::string();
+    }
+
+    unsigned char serial[256];
+    auto len = libusb_get_string_descriptor_ascii(device, desc.iSerialNumber, serial, sizeof(serial));
+    if (len <= 0)
+    {
+        return std::string();
+    }
+    return std::string(reinterpret_cast<const char *>(serial), len);
+}
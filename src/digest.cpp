@@ -0,0 +1,437 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <radio_tool/util/digest.hpp>
+#include <radio_tool/util/cpu.hpp>
+
+#include <cstring>
+#include <sstream>
+#include <iomanip>
+
+#ifdef RADIO_TOOL_X86
+#include <immintrin.h>
+#endif
+
+using namespace radio_tool::digest;
+
+namespace
+{
+    typedef uint32_t (*CRC32Kernel)(const uint8_t *data, size_t len, uint32_t crc);
+    typedef void (*SHA256Kernel)(uint32_t *state, const uint8_t *data, size_t blocks);
+
+    class KernelSet
+    {
+    public:
+        const char *crc32_name;
+        CRC32Kernel crc32;
+        const char *sha256_name;
+        SHA256Kernel sha256;
+    };
+
+    /**
+     * Reflected CRC-32 polynomial
+     */
+    constexpr uint32_t CRC32Poly = 0xedb88320;
+
+    /**
+     * Slicing-by-8 tables, table[0] is the normal byte table
+     */
+    constexpr auto MakeCRC32Tables() -> std::array<std::array<uint32_t, 256>, 8>
+    {
+        std::array<std::array<uint32_t, 256>, 8> ret = {};
+        for (uint32_t x = 0; x < 256; x++)
+        {
+            auto c = x;
+            for (auto b = 0; b < 8; b++)
+            {
+                c = (c & 1) ? (c >> 1) ^ CRC32Poly : c >> 1;
+            }
+            ret[0][x] = c;
+        }
+        for (uint32_t x = 0; x < 256; x++)
+        {
+            for (auto t = 1; t < 8; t++)
+            {
+                ret[t][x] = (ret[t - 1][x] >> 8) ^ ret[0][ret[t - 1][x] & 0xff];
+            }
+        }
+        return ret;
+    }
+
+    constexpr auto CRC32Tables = MakeCRC32Tables();
+
+    /**
+     * CRC register (not inverted) over data
+     */
+    auto CRC32Scalar(const uint8_t *data, size_t len, uint32_t crc) -> uint32_t
+    {
+        const auto &t = CRC32Tables;
+        while (len >= 8)
+        {
+            auto a = crc ^ (data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24));
+            crc = t[7][a & 0xff] ^ t[6][(a >> 8) & 0xff] ^ t[5][(a >> 16) & 0xff] ^ t[4][a >> 24] ^
+                  t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+            data += 8;
+            len -= 8;
+        }
+        while (len-- > 0)
+        {
+            crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xff];
+        }
+        return crc;
+    }
+
+    constexpr uint32_t SHA256K[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+    constexpr auto ROTR(const uint32_t &x, const int &n) -> uint32_t
+    {
+        return (x >> n) | (x << (32 - n));
+    }
+
+    auto SHA256Scalar(uint32_t *state, const uint8_t *data, size_t blocks) -> void
+    {
+        uint32_t w[64];
+        for (; blocks > 0; blocks--, data += 64)
+        {
+            for (auto i = 0; i < 16; i++)
+            {
+                w[i] = ((uint32_t)data[i * 4] << 24) | (data[i * 4 + 1] << 16) | (data[i * 4 + 2] << 8) | data[i * 4 + 3];
+            }
+            for (auto i = 16; i < 64; i++)
+            {
+                auto s0 = ROTR(w[i - 15], 7) ^ ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                auto s1 = ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+
+            auto a = state[0], b = state[1], c = state[2], d = state[3],
+                 e = state[4], f = state[5], g = state[6], h = state[7];
+            for (auto i = 0; i < 64; i++)
+            {
+                auto s1 = ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25);
+                auto ch = (e & f) ^ (~e & g);
+                auto t1 = h + s1 + ch + SHA256K[i] + w[i];
+                auto s0 = ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22);
+                auto maj = (a & b) ^ (a & c) ^ (b & c);
+                auto t2 = s0 + maj;
+                h = g;
+                g = f;
+                f = e;
+                e = d + t1;
+                d = c;
+                c = b;
+                b = a;
+                a = t1 + t2;
+            }
+            state[0] += a;
+            state[1] += b;
+            state[2] += c;
+            state[3] += d;
+            state[4] += e;
+            state[5] += f;
+            state[6] += g;
+            state[7] += h;
+        }
+    }
+
+#ifdef RADIO_TOOL_X86
+    /**
+     * Fold x forward by 128 bits onto next
+     */
+    RADIO_TOOL_TARGET("pclmul,sse4.1")
+    inline auto Fold128(const __m128i &x, const __m128i &next, const __m128i &k) -> __m128i
+    {
+        auto lo = _mm_clmulepi64_si128(x, k, 0x00);
+        auto hi = _mm_clmulepi64_si128(x, k, 0x11);
+        return _mm_xor_si128(_mm_xor_si128(hi, next), lo);
+    }
+
+    /**
+     * Fold 4x128 bits at a time with carry-less multiplies, then Barrett reduce
+     * @note Intel "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ",
+     *       len must be >= 64 and a multiple of 16
+     */
+    RADIO_TOOL_TARGET("pclmul,sse4.1")
+    auto CRC32PCLMUL(const uint8_t *data, size_t len, uint32_t crc) -> uint32_t
+    {
+        const auto k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+        const auto k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+        const auto k5k0 = _mm_set_epi64x(0x0000000000, 0x0163cd6124);
+        const auto poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+        const auto mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+        auto x1 = _mm_loadu_si128((const __m128i *)(data + 0x00));
+        auto x2 = _mm_loadu_si128((const __m128i *)(data + 0x10));
+        auto x3 = _mm_loadu_si128((const __m128i *)(data + 0x20));
+        auto x4 = _mm_loadu_si128((const __m128i *)(data + 0x30));
+        x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+        data += 64;
+        len -= 64;
+
+        while (len >= 64)
+        {
+            auto x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+            auto x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+            auto x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+            auto x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+
+            x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+            x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+            x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+            x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+
+            x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i *)(data + 0x00)));
+            x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i *)(data + 0x10)));
+            x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i *)(data + 0x20)));
+            x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i *)(data + 0x30)));
+
+            data += 64;
+            len -= 64;
+        }
+
+        //fold 512 bits into 128
+        x1 = Fold128(x1, x2, k3k4);
+        x1 = Fold128(x1, x3, k3k4);
+        x1 = Fold128(x1, x4, k3k4);
+
+        for (; len >= 16; data += 16, len -= 16)
+        {
+            x1 = Fold128(x1, _mm_loadu_si128((const __m128i *)data), k3k4);
+        }
+
+        //fold 128 bits to 64
+        x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+        x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+        x2 = _mm_srli_si128(x1, 4);
+        x1 = _mm_and_si128(x1, mask32);
+        x1 = _mm_clmulepi64_si128(x1, k5k0, 0x00);
+        x1 = _mm_xor_si128(x1, x2);
+
+        //barrett reduce to 32 bits
+        x2 = _mm_and_si128(x1, mask32);
+        x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+        x2 = _mm_and_si128(x2, mask32);
+        x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+        x1 = _mm_xor_si128(x1, x2);
+
+        return _mm_extract_epi32(x1, 1);
+    }
+
+    /**
+     * SHA-256 using the SHA extensions, state is kept as ABEF/CDGH
+     */
+    RADIO_TOOL_TARGET("sha,ssse3,sse4.1")
+    auto SHA256SHANI(uint32_t *state, const uint8_t *data, size_t blocks) -> void
+    {
+        const auto shuf = _mm_set_epi64x(0x0c0d0e0f08090a0bull, 0x0405060700010203ull);
+
+        auto tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]), 0xb1); //CDAB
+        auto state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[4]), 0x1b); //EFGH
+        auto state0 = _mm_alignr_epi8(tmp, state1, 8); //ABEF
+        state1 = _mm_blend_epi16(state1, tmp, 0xf0); //CDGH
+
+        for (; blocks > 0; blocks--, data += 64)
+        {
+            auto abef = state0;
+            auto cdgh = state1;
+
+            __m128i w[4];
+            RADIO_TOOL_UNROLL_FULL
+            for (auto g = 0; g < 16; g++)
+            {
+                auto &cur = w[g & 3];
+                if (g < 4)
+                {
+                    cur = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + (g * 16))), shuf);
+                }
+
+                auto msg = _mm_add_epi32(cur, _mm_loadu_si128((const __m128i *)&SHA256K[g * 4]));
+                state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+
+                //finish the schedule of the next 4 words
+                if (g >= 3 && g <= 14)
+                {
+                    auto &next = w[(g + 1) & 3];
+                    next = _mm_add_epi32(next, _mm_alignr_epi8(cur, w[(g - 1) & 3], 4));
+                    next = _mm_sha256msg2_epu32(next, cur);
+                }
+
+                state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(msg, 0x0e));
+
+                //start the schedule of the words 12 ahead
+                if (g >= 1 && g <= 12)
+                {
+                    auto &prev = w[(g - 1) & 3];
+                    prev = _mm_sha256msg1_epu32(prev, cur);
+                }
+            }
+
+            state0 = _mm_add_epi32(state0, abef);
+            state1 = _mm_add_epi32(state1, cdgh);
+        }
+
+        tmp = _mm_shuffle_epi32(state0, 0x1b); //FEBA
+        state1 = _mm_shuffle_epi32(state1, 0xb1); //DCHG
+        state0 = _mm_blend_epi16(tmp, state1, 0xf0); //DCBA
+        state1 = _mm_alignr_epi8(state1, tmp, 8); //HGFE
+        _mm_storeu_si128((__m128i *)&state[0], state0);
+        _mm_storeu_si128((__m128i *)&state[4], state1);
+    }
+#endif
+
+    auto SelectKernel() -> KernelSet
+    {
+        KernelSet ret = {"scalar", CRC32Scalar, "scalar", SHA256Scalar};
+#ifdef RADIO_TOOL_X86
+        const auto &cpu = radio_tool::cpu::GetFeatures();
+        if (cpu.pclmul && cpu.sse41)
+        {
+            ret.crc32_name = "pclmul";
+            ret.crc32 = CRC32PCLMUL;
+        }
+        if (cpu.sha && cpu.ssse3 && cpu.sse41)
+        {
+            ret.sha256_name = "sha-ni";
+            ret.sha256 = SHA256SHANI;
+        }
+#endif
+        return ret;
+    }
+
+    auto GetKernel() -> const KernelSet &
+    {
+        static const auto kernel = SelectKernel();
+        return kernel;
+    }
+
+    /**
+     * Smallest input for the folding kernel
+     */
+    constexpr auto MinFoldLength = 64u;
+} // namespace
+
+auto radio_tool::digest::CRC32(const uint8_t *data, const size_t &len, const uint32_t &crc) -> uint32_t
+{
+    const auto &k = GetKernel();
+    auto r = ~crc;
+    auto done = size_t(0);
+    if (k.crc32 != CRC32Scalar && len >= MinFoldLength)
+    {
+        done = len & ~size_t(15);
+        r = k.crc32(data, done, r);
+    }
+    return ~CRC32Scalar(data + done, len - done, r);
+}
+
+SHA256::SHA256()
+    : state({0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19}),
+      buffer({}),
+      length(0)
+{
+}
+
+auto SHA256::Update(const uint8_t *data, const size_t &len) -> void
+{
+    const auto &k = GetKernel();
+    auto n = len;
+    auto used = length % buffer.size();
+    length += len;
+
+    //fill a partial block first
+    if (used > 0)
+    {
+        auto take = std::min<size_t>(n, buffer.size() - used);
+        memcpy(buffer.data() + used, data, take);
+        data += take;
+        n -= take;
+        if (used + take < buffer.size())
+        {
+            return;
+        }
+        k.sha256(state.data(), buffer.data(), 1);
+    }
+
+    //whole blocks straight from the input
+    auto blocks = n / buffer.size();
+    if (blocks > 0)
+    {
+        k.sha256(state.data(), data, blocks);
+        data += blocks * buffer.size();
+        n -= blocks * buffer.size();
+    }
+    if (n > 0)
+    {
+        memcpy(buffer.data(), data, n);
+    }
+}
+
+auto SHA256::Finalize() -> SHA256Digest
+{
+    auto bits = length * 8;
+
+    //0x80 then zeros until 8 bytes from the end of a block, then the bit length
+    uint8_t pad[72] = {0x80};
+    auto used = length % 64;
+    auto pad_len = (used < 56 ? 56 - used : 120 - used);
+    for (auto x = 0; x < 8; x++)
+    {
+        pad[pad_len + x] = (uint8_t)(bits >> (56 - (x * 8)));
+    }
+    Update(pad, pad_len + 8);
+
+    SHA256Digest ret;
+    for (auto x = 0u; x < state.size(); x++)
+    {
+        ret[x * 4] = (uint8_t)(state[x] >> 24);
+        ret[x * 4 + 1] = (uint8_t)(state[x] >> 16);
+        ret[x * 4 + 2] = (uint8_t)(state[x] >> 8);
+        ret[x * 4 + 3] = (uint8_t)state[x];
+    }
+    return ret;
+}
+
+auto SHA256::Hash(const uint8_t *data, const size_t &len) -> SHA256Digest
+{
+    SHA256 h;
+    h.Update(data, len);
+    return h.Finalize();
+}
+
+auto radio_tool::digest::ToHex(const SHA256Digest &digest) -> std::string
+{
+    std::stringstream out;
+    for (const auto &b : digest)
+    {
+        out << std::setw(2) << std::setfill('0') << std::hex << (int)b;
+    }
+    return out.str();
+}
+
+auto radio_tool::digest::GetKernelName() -> std::string
+{
+    const auto &k = GetKernel();
+    return std::string(k.crc32_name) + "/" + k.sha256_name;
+}
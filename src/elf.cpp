@@ -0,0 +1,122 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <radio_tool/util/elf.hpp>
+
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace radio_tool::elf;
+
+namespace
+{
+    constexpr uint8_t ElfMagic[] = {0x7f, 'E', 'L', 'F'};
+    constexpr uint8_t ElfClass32 = 1;
+    constexpr uint8_t ElfDataLSB = 1;
+    constexpr uint32_t PT_LOAD = 1;
+
+    typedef struct
+    {
+        uint8_t e_ident[16];
+        uint16_t e_type;
+        uint16_t e_machine;
+        uint32_t e_version;
+        uint32_t e_entry;
+        uint32_t e_phoff;
+        uint32_t e_shoff;
+        uint32_t e_flags;
+        uint16_t e_ehsize;
+        uint16_t e_phentsize;
+        uint16_t e_phnum;
+        uint16_t e_shentsize;
+        uint16_t e_shnum;
+        uint16_t e_shstrndx;
+    } Elf32Header;
+    static_assert(sizeof(Elf32Header) == 52);
+
+    typedef struct
+    {
+        uint32_t p_type;
+        uint32_t p_offset;
+        uint32_t p_vaddr;
+        uint32_t p_paddr;
+        uint32_t p_filesz;
+        uint32_t p_memsz;
+        uint32_t p_flags;
+        uint32_t p_align;
+    } Elf32ProgramHeader;
+    static_assert(sizeof(Elf32ProgramHeader) == 32);
+} // namespace
+
+auto ElfFile::IsElf(const ByteView &header) -> bool
+{
+    return header.size() >= sizeof(ElfMagic) && std::equal(ElfMagic, ElfMagic + sizeof(ElfMagic), header.begin());
+}
+
+auto ElfFile::Open(const std::string &path) -> ElfFile
+{
+    ElfFile ret;
+    ret.file = MappedFile::Open(path);
+    auto whole = ByteView(ret.file->GetData(), ret.file->GetSize());
+
+    if (!IsElf(whole) || whole.size() < sizeof(Elf32Header))
+    {
+        throw std::runtime_error("Not an ELF file");
+    }
+
+    Elf32Header eh;
+    memcpy(&eh, whole.data(), sizeof(eh));
+    if (eh.e_ident[4] != ElfClass32 || eh.e_ident[5] != ElfDataLSB)
+    {
+        throw std::runtime_error("Only 32-bit little endian ELF files are supported");
+    }
+    if (eh.e_phentsize != sizeof(Elf32ProgramHeader))
+    {
+        throw std::runtime_error("Invalid ELF program header size");
+    }
+
+    if (eh.e_phoff > whole.size() || static_cast<uint64_t>(eh.e_phnum) * sizeof(Elf32ProgramHeader) > whole.size() - eh.e_phoff)
+    {
+        throw std::runtime_error("ELF program headers are past the end of the file");
+    }
+
+    for (auto x = 0u; x < eh.e_phnum; x++)
+    {
+        Elf32ProgramHeader ph;
+        memcpy(&ph, whole.data() + eh.e_phoff + x * sizeof(ph), sizeof(ph));
+        if (ph.p_type != PT_LOAD || ph.p_filesz == 0)
+        {
+            continue;
+        }
+        if (static_cast<uint64_t>(ph.p_paddr) + ph.p_filesz > static_cast<uint64_t>(UINT32_MAX) + 1)
+        {
+            throw std::runtime_error("ELF segment address out of range");
+        }
+        if (ph.p_offset > whole.size() || ph.p_filesz > whole.size() - ph.p_offset)
+        {
+            throw std::runtime_error("ELF segment is past the end of the file");
+        }
+
+        ret.segments.push_back({ph.p_paddr, whole.Sub(ph.p_offset, ph.p_filesz)});
+    }
+
+    std::sort(ret.segments.begin(), ret.segments.end(), [](const LoadSegment &a, const LoadSegment &b) {
+        return a.address < b.address;
+    });
+    return ret;
+}
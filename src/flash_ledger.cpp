@@ -0,0 +1,93 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <radio_tool/radio/flash_ledger.hpp>
+
+#include <cctype>
+#include <cstdlib>
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+
+using namespace radio_tool::radio;
+
+namespace fs = std::filesystem;
+
+FlashLedger::FlashLedger(const std::string &radio_id, const std::string &dir)
+{
+    if (radio_id.empty() || radio_id.size() > 64 || !std::all_of(radio_id.begin(), radio_id.end(), [](const char &c) {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_';
+        }))
+    {
+        throw std::invalid_argument("Invalid radio id for the flash ledger: " + radio_id);
+    }
+
+    auto base = fs::path(dir.empty() ? GetDefaultDir() : dir);
+    path = (base / (radio_id + ".bin")).string();
+}
+
+auto FlashLedger::GetDefaultDir() -> std::string
+{
+    if (auto env = std::getenv("RADIO_TOOL_LEDGER"))
+    {
+        return env;
+    }
+#ifdef _WIN32
+    if (auto appdata = std::getenv("APPDATA"))
+    {
+        return (fs::path(appdata) / "radio_tool" / "ledger").string();
+    }
+#else
+    if (auto xdg = std::getenv("XDG_DATA_HOME"))
+    {
+        return (fs::path(xdg) / "radio_tool" / "ledger").string();
+    }
+    if (auto home = std::getenv("HOME"))
+    {
+        return (fs::path(home) / ".local" / "share" / "radio_tool" / "ledger").string();
+    }
+#endif
+    return ".radio_tool_ledger";
+}
+
+auto FlashLedger::GetInstalled() const -> std::optional<std::string>
+{
+    std::error_code ec;
+    if (fs::is_regular_file(path, ec))
+    {
+        return path;
+    }
+    return {};
+}
+
+auto FlashLedger::Invalidate() const -> void
+{
+    std::error_code ec;
+    fs::remove(path, ec);
+    if (ec)
+    {
+        throw std::runtime_error("Failed to remove ledger entry: " + path);
+    }
+}
+
+auto FlashLedger::Store(const std::string &fw_file) const -> void
+{
+    auto tmp = path + ".tmp";
+    fs::create_directories(fs::path(path).parent_path());
+    fs::copy_file(fw_file, tmp, fs::copy_options::overwrite_existing);
+    fs::rename(tmp, path);
+}
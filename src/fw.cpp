@@ -0,0 +1,128 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <radio_tool/fw/fw.hpp>
+
+#include <limits>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+
+using namespace radio_tool::fw;
+
+auto FirmwareSupport::PlanSegments(const std::vector<std::pair<uint32_t, std::string>> &segments) -> void
+{
+    memory_ranges.clear();
+    for (const auto &sx : segments)
+    {
+        std::ifstream f_seg(sx.second, std::ios_base::binary | std::ios_base::ate);
+        if (!f_seg.is_open())
+        {
+            throw std::runtime_error("Cant open file for segment");
+        }
+
+        uint64_t new_size = PaddedSize(static_cast<uint64_t>(f_seg.tellg()));
+        if (new_size > std::numeric_limits<uint32_t>::max())
+        {
+            throw std::runtime_error("Segment file too large");
+        }
+        memory_ranges.push_back({sx.first, static_cast<uint32_t>(new_size)});
+    }
+    data = FirmwareBuffer();
+    InvalidateCache();
+}
+
+auto FirmwareSupport::StreamSegments(std::ostream &out, const std::vector<std::pair<uint32_t, std::string>> &segments,
+                                     const std::function<void(const uint8_t *, const size_t &)> &plain) const -> void
+{
+    if (segments.size() != memory_ranges.size())
+    {
+        throw std::runtime_error("Segments do not match memory ranges");
+    }
+
+    auto cipher = GetCipher();
+    std::vector<uint8_t> chunk(StreamChunkSize);
+    for (auto idx = 0u; idx < segments.size(); idx++)
+    {
+        std::ifstream f_seg(segments[idx].second, std::ios_base::binary);
+        if (!f_seg.is_open())
+        {
+            throw std::runtime_error("Cant open file for segment");
+        }
+
+        //padding is read past the end of the file as 0xff
+        uint64_t left = memory_ranges[idx].second;
+        while (left > 0)
+        {
+            auto n = static_cast<size_t>(std::min<uint64_t>(left, chunk.size()));
+            f_seg.read((char *)chunk.data(), n);
+            auto got = static_cast<size_t>(f_seg.gcount());
+            std::fill(chunk.begin() + got, chunk.begin() + n, 0xff);
+
+            if (plain)
+            {
+                plain(chunk.data(), n);
+            }
+            cipher.Apply(chunk.data(), n);
+            out.write((const char *)chunk.data(), n);
+            left -= n;
+        }
+    }
+
+    if (!out)
+    {
+        throw std::runtime_error("Failed to write file");
+    }
+}
+
+auto FirmwareSupport::UnwrapSegments(const std::string &prefix) const -> std::vector<std::string>
+{
+    std::vector<std::string> ret;
+    auto cipher = GetCipher();
+    std::vector<uint8_t> chunk(StreamChunkSize);
+
+    //segment views are bounds checked, a header only read fails here before any file is created
+    const auto &segments = GetDataSegments();
+    auto r_offset = 0u;
+    for (const auto &seg : segments)
+    {
+        std::stringstream ss_name;
+        ss_name << prefix << "_0x" << std::setw(8) << std::setfill('0') << std::hex << seg.address;
+
+        std::ofstream fw_out(ss_name.str(), std::ios_base::out | std::ios_base::binary);
+        if (!fw_out.is_open())
+        {
+            throw std::runtime_error("Failed to open output file: " + ss_name.str());
+        }
+
+        for (auto offset = 0u; offset < seg.size; offset += chunk.size())
+        {
+            auto n = std::min<uint32_t>(chunk.size(), seg.size - offset);
+            std::copy_n(seg.data.begin() + offset, n, chunk.begin());
+            cipher.ApplyAt(r_offset + offset, chunk.data(), n);
+            fw_out.write((const char *)chunk.data(), n);
+        }
+        if (!fw_out)
+        {
+            throw std::runtime_error("Failed to write file: " + ss_name.str());
+        }
+        r_offset += seg.size;
+        ret.push_back(ss_name.str());
+    }
+    return ret;
+}
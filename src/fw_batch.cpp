@@ -0,0 +1,297 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <radio_tool/fw/fw_batch.hpp>
+#include <radio_tool/fw/fw_factory.hpp>
+#include <radio_tool/util/thread_pool.hpp>
+
+#include <set>
+#include <map>
+#include <mutex>
+#include <memory>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <filesystem>
+
+using namespace radio_tool::fw;
+
+namespace fs = std::filesystem;
+
+static auto JSONString(const std::string &str) -> std::string
+{
+    std::stringstream out;
+    out << '"';
+    for (const auto &c : str)
+    {
+        switch (c)
+        {
+        case '"':
+            out << "\\\"";
+            break;
+        case '\\':
+            out << "\\\\";
+            break;
+        case '\n':
+            out << "\\n";
+            break;
+        case '\r':
+            out << "\\r";
+            break;
+        case '\t':
+            out << "\\t";
+            break;
+        default:
+            if ((uint8_t)c < 0x20)
+            {
+                out << "\\u" << std::setw(4) << std::setfill('0') << std::hex << (int)c << std::dec;
+            }
+            else
+            {
+                out << c;
+            }
+        }
+    }
+    out << '"';
+    return out.str();
+}
+
+auto FirmwareBatch::GlobMatch(const char *pattern, const char *name) -> bool
+{
+    const char *star = nullptr, *retry = nullptr;
+    while (*name)
+    {
+        if (*pattern == '?' || *pattern == *name)
+        {
+            pattern++;
+            name++;
+        }
+        else if (*pattern == '*')
+        {
+            star = pattern++;
+            retry = name;
+        }
+        else if (star)
+        {
+            pattern = star + 1;
+            name = ++retry;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    while (*pattern == '*')
+    {
+        pattern++;
+    }
+    return *pattern == 0;
+}
+
+auto BatchRecord::ToJSON() const -> std::string
+{
+    std::stringstream out;
+    out << "{\"file\":" << JSONString(file)
+        << ",\"model\":" << (model.empty() ? "null" : JSONString(model))
+        << ",\"size\":" << size
+        << ",\"segments\":[";
+    for (auto x = 0u; x < segments.size(); x++)
+    {
+        out << (x > 0 ? "," : "")
+            << "{\"address\":\"0x" << std::setw(8) << std::setfill('0') << std::hex << segments[x].first << std::dec
+            << "\",\"size\":" << segments[x].second << "}";
+    }
+    out << "]";
+    if (!outputs.empty())
+    {
+        out << ",\"outputs\":[";
+        for (auto x = 0u; x < outputs.size(); x++)
+        {
+            out << (x > 0 ? "," : "") << JSONString(outputs[x]);
+        }
+        out << "]";
+    }
+    if (crc32)
+    {
+        out << ",\"crc32\":\"" << std::setw(8) << std::setfill('0') << std::hex << *crc32 << std::dec << "\"";
+    }
+    if (sha256)
+    {
+        out << ",\"sha256\":\"" << digest::ToHex(*sha256) << "\"";
+    }
+    out << ",\"error\":" << (error.empty() ? "null" : JSONString(error)) << "}";
+    return out.str();
+}
+
+auto FirmwareBatch::ExpandInputs(const std::vector<std::string> &inputs) -> std::vector<std::string>
+{
+    std::vector<std::string> ret;
+    for (const auto &in : inputs)
+    {
+        std::error_code ec;
+        std::vector<std::string> found;
+        fs::path p(in);
+        if (fs::is_directory(p, ec))
+        {
+            for (const auto &e : fs::recursive_directory_iterator(p, fs::directory_options::skip_permission_denied, ec))
+            {
+                if (e.is_regular_file(ec))
+                {
+                    found.push_back(e.path().string());
+                }
+            }
+        }
+        else if (!fs::exists(p, ec) && p.filename().string().find_first_of("*?") != std::string::npos)
+        {
+            auto dir = p.has_parent_path() ? p.parent_path() : fs::path(".");
+            auto pattern = p.filename().string();
+            for (const auto &e : fs::directory_iterator(dir, ec))
+            {
+                if (e.is_regular_file(ec) && GlobMatch(pattern.c_str(), e.path().filename().string().c_str()))
+                {
+                    found.push_back(p.has_parent_path() ? e.path().string() : e.path().filename().string());
+                }
+            }
+        }
+
+        if (found.empty())
+        {
+            ret.push_back(in);
+        }
+        else
+        {
+            std::sort(found.begin(), found.end());
+            ret.insert(ret.end(), found.begin(), found.end());
+        }
+    }
+    return ret;
+}
+
+auto FirmwareBatch::GetOutputPrefixes(const std::vector<std::string> &files, const std::string &out_dir) -> std::vector<std::string>
+{
+    std::map<std::string, size_t> names;
+    for (const auto &f : files)
+    {
+        names[fs::path(f).filename().string()]++;
+    }
+
+    std::set<std::string> used;
+    std::vector<std::string> ret;
+    for (const auto &f : files)
+    {
+        auto name = fs::path(f).filename().string();
+        if (names[name] > 1)
+        {
+            std::stringstream ss;
+            ss << name << "_" << std::setw(8) << std::setfill('0') << std::hex << digest::CRC32((const uint8_t *)f.data(), f.size());
+            name = ss.str();
+        }
+
+        auto prefix = (fs::path(out_dir) / name).string();
+        ret.push_back(used.insert(prefix).second ? prefix : std::string());
+    }
+    return ret;
+}
+
+auto FirmwareBatch::Process(const std::string &file, const BatchOptions &opt, const std::string &out_prefix) -> BatchRecord
+{
+    BatchRecord ret;
+    ret.file = file;
+    try
+    {
+        std::unique_ptr<FirmwareSupport> fw;
+        if (opt.op == BatchOp::Info && !opt.digest)
+        {
+            fw = FirmwareFactory::GetFirmwareFileInfo(file);
+        }
+        else
+        {
+            fw = FirmwareFactory::GetFirmwareFileHandler(file);
+            fw->Read(file);
+        }
+
+        ret.model = fw->GetRadioModel();
+        ret.size = fw->GetImageSize();
+        ret.segments = fw->GetMemoryRanges();
+
+        if (opt.op == BatchOp::Unwrap)
+        {
+            if (out_prefix.empty())
+            {
+                throw std::runtime_error("Output files collide with another input");
+            }
+            ret.outputs = fw->UnwrapSegments(out_prefix);
+        }
+        else if (opt.digest)
+        {
+            fw->Decrypt();
+            ret.crc32 = fw->GetCRC32();
+            ret.sha256 = fw->GetSHA256();
+        }
+    }
+    catch (const std::exception &ex)
+    {
+        ret.error = ex.what();
+    }
+    return ret;
+}
+
+auto FirmwareBatch::Run(const std::vector<std::string> &files, const BatchOptions &opt, const std::function<void(const BatchRecord &)> &emit) -> size_t
+{
+    if (opt.op == BatchOp::Unwrap)
+    {
+        fs::create_directories(opt.out_dir);
+    }
+
+    //records are emitted in order as soon as all earlier files are done
+    std::vector<std::optional<BatchRecord>> results(files.size());
+    std::mutex lock;
+    size_t next = 0, failed = 0;
+
+    auto prefixes = GetOutputPrefixes(files, opt.out_dir);
+    auto fn = [&](const size_t &idx) {
+        auto rec = Process(files[idx], opt, prefixes[idx]);
+
+        std::lock_guard<std::mutex> lk(lock);
+        results[idx] = std::move(rec);
+        for (; next < results.size() && results[next]; next++)
+        {
+            if (!results[next]->error.empty())
+            {
+                failed++;
+            }
+            emit(*results[next]);
+            results[next].reset();
+        }
+    };
+
+    //the calling thread runs tasks too, so jobs - 1 workers
+    auto jobs = opt.jobs != 0 ? opt.jobs : std::max(1u, std::thread::hardware_concurrency());
+    if (jobs > 1)
+    {
+        thread::ThreadPool pool(jobs - 1);
+        pool.ParallelFor(files.size(), fn);
+    }
+    else
+    {
+        for (auto x = 0u; x < files.size(); x++)
+        {
+            fn(x);
+        }
+    }
+    return failed;
+}
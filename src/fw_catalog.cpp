@@ -0,0 +1,309 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <radio_tool/fw/fw_catalog.hpp>
+#include <radio_tool/fw/fw_factory.hpp>
+#include <radio_tool/util/mapped_file.hpp>
+#include <radio_tool/util/thread_pool.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <filesystem>
+
+using namespace radio_tool::fw;
+
+namespace fs = std::filesystem;
+
+/**
+ * First line of the index file, bump the version when the format changes
+ */
+constexpr auto IndexMagic = "radio_tool-catalog 1";
+
+static auto ParseDigest(const std::string &hex, radio_tool::digest::SHA256Digest &out) -> bool
+{
+    if (hex.size() != out.size() * 2)
+    {
+        return false;
+    }
+    for (auto x = 0u; x < out.size(); x++)
+    {
+        out[x] = static_cast<uint8_t>(std::stoul(hex.substr(x * 2, 2), nullptr, 16));
+    }
+    return true;
+}
+
+static auto GetMTime(const fs::path &p) -> int64_t
+{
+    return static_cast<int64_t>(fs::last_write_time(p).time_since_epoch().count());
+}
+
+FirmwareCatalog::FirmwareCatalog(const std::string &dir)
+    : dir(dir)
+{
+    Load();
+}
+
+auto FirmwareCatalog::GetIndexPath() const -> std::string
+{
+    return (fs::path(dir) / IndexName).string();
+}
+
+/**
+ * One tab separated line per file:
+ * path, file_size, mtime, sha256, handler, model, image_size, address:length,...
+ */
+auto FirmwareCatalog::Load() -> void
+{
+    entries.clear();
+
+    std::ifstream in(GetIndexPath());
+    std::string line;
+    if (!in.is_open() || !std::getline(in, line) || line != IndexMagic)
+    {
+        //missing or old index, everything is read again
+        Reindex();
+        return;
+    }
+
+    while (std::getline(in, line))
+    {
+        std::vector<std::string> cols;
+        std::stringstream ss(line);
+        std::string col;
+        while (std::getline(ss, col, '\t'))
+        {
+            cols.push_back(col);
+        }
+        if (cols.size() < 7)
+        {
+            continue;
+        }
+
+        try
+        {
+            CatalogEntry e;
+            e.path = cols[0];
+            e.file_size = std::stoull(cols[1]);
+            e.mtime = std::stoll(cols[2]);
+            if (!ParseDigest(cols[3], e.sha256))
+            {
+                continue;
+            }
+            e.handler = cols[4];
+            e.model = cols[5];
+            e.image_size = std::stoull(cols[6]);
+            if (cols.size() > 7)
+            {
+                std::stringstream segs(cols[7]);
+                std::string seg;
+                while (std::getline(segs, seg, ','))
+                {
+                    auto sep = seg.find(':');
+                    if (sep != seg.npos)
+                    {
+                        e.segments.push_back({static_cast<uint32_t>(std::stoul(seg.substr(0, sep), nullptr, 16)),
+                                              static_cast<uint32_t>(std::stoul(seg.substr(sep + 1), nullptr, 16))});
+                    }
+                }
+            }
+            entries.push_back(std::move(e));
+        }
+        catch (const std::exception &)
+        {
+            //skip damaged lines, the files are indexed again on update
+        }
+    }
+    Reindex();
+}
+
+auto FirmwareCatalog::Save() const -> void
+{
+    //write a temp file and rename so a crash never leaves a half written index
+    auto tmp = GetIndexPath() + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios_base::trunc);
+        if (!out.is_open())
+        {
+            throw std::runtime_error("Cant open file");
+        }
+
+        out << IndexMagic << "\n";
+        for (const auto &e : entries)
+        {
+            out << e.path << "\t" << e.file_size << "\t" << e.mtime << "\t" << digest::ToHex(e.sha256) << "\t"
+                << e.handler << "\t" << e.model << "\t" << e.image_size << "\t";
+            for (auto x = 0u; x < e.segments.size(); x++)
+            {
+                out << (x > 0 ? "," : "") << std::hex << e.segments[x].first << ":" << e.segments[x].second << std::dec;
+            }
+            out << "\n";
+        }
+        if (!out)
+        {
+            throw std::runtime_error("Failed to write file");
+        }
+    }
+    fs::rename(tmp, GetIndexPath());
+}
+
+auto FirmwareCatalog::MakeEntry(const std::string &file, const std::string &path) -> CatalogEntry
+{
+    CatalogEntry ret;
+    ret.path = path;
+    ret.mtime = GetMTime(file);
+
+    auto mf = MappedFile::Open(file);
+    ret.file_size = mf->GetSize();
+    ret.sha256 = digest::SHA256::Hash(mf->GetData(), mf->GetSize());
+
+    try
+    {
+        auto prefix = ByteView(mf->GetData(), std::min<uint64_t>(mf->GetSize(), FirmwareFactory::SniffSize));
+        const auto &h = FirmwareFactory::GetFirmwareHandler(prefix, mf->GetSize());
+        auto fw = h.CreateHandler();
+        fw->ReadHeader(prefix, mf->GetSize());
+
+        ret.handler = h.Name;
+        ret.model = fw->GetRadioModel();
+        ret.image_size = fw->GetImageSize();
+        ret.segments = fw->GetMemoryRanges();
+    }
+    catch (const std::exception &)
+    {
+        //not a firmware file, keep the digest so it is not read again
+        ret.handler.clear();
+        ret.model.clear();
+        ret.image_size = 0;
+        ret.segments.clear();
+    }
+    return ret;
+}
+
+auto FirmwareCatalog::Update() -> size_t
+{
+    std::unordered_map<std::string, size_t> by_path;
+    for (auto x = 0u; x < entries.size(); x++)
+    {
+        by_path[entries[x].path] = x;
+    }
+
+    //keep unchanged entries, collect the files which need reading
+    std::vector<CatalogEntry> next;
+    std::vector<std::pair<std::string, std::string>> todo;
+    for (const auto &de : fs::recursive_directory_iterator(dir, fs::directory_options::skip_permission_denied))
+    {
+        if (!de.is_regular_file())
+        {
+            continue;
+        }
+
+        auto path = fs::relative(de.path(), dir).generic_string();
+        if (path == IndexName || path == std::string(IndexName) + ".tmp"
+            || path.find_first_of("\t\n") != path.npos)
+        {
+            continue;
+        }
+
+        auto it = by_path.find(path);
+        if (it != by_path.end()
+            && entries[it->second].file_size == de.file_size()
+            && entries[it->second].mtime == GetMTime(de.path()))
+        {
+            next.push_back(std::move(entries[it->second]));
+        }
+        else
+        {
+            todo.push_back({de.path().string(), path});
+        }
+    }
+
+    std::vector<CatalogEntry> fresh(todo.size());
+    thread::ThreadPool::Shared().ParallelFor(todo.size(), [&](const size_t &idx) {
+        try
+        {
+            fresh[idx] = MakeEntry(todo[idx].first, todo[idx].second);
+        }
+        catch (const std::exception &)
+        {
+            //unreadable files are left out and retried on the next update
+        }
+    });
+
+    for (auto &e : fresh)
+    {
+        if (!e.path.empty())
+        {
+            next.push_back(std::move(e));
+        }
+    }
+    std::sort(next.begin(), next.end(), [](const CatalogEntry &a, const CatalogEntry &b) {
+        return a.path < b.path;
+    });
+    entries = std::move(next);
+    Reindex();
+    return todo.size();
+}
+
+auto FirmwareCatalog::Reindex() -> void
+{
+    by_digest.clear();
+    by_model.clear();
+    for (auto x = 0u; x < entries.size(); x++)
+    {
+        by_digest[entries[x].sha256].push_back(x);
+        if (entries[x].IsFirmware())
+        {
+            by_model[entries[x].model].push_back(x);
+        }
+    }
+}
+
+auto FirmwareCatalog::FindDigest(const digest::SHA256Digest &sha256) const -> std::vector<const CatalogEntry *>
+{
+    std::vector<const CatalogEntry *> ret;
+    auto it = by_digest.find(sha256);
+    if (it != by_digest.end())
+    {
+        for (const auto &idx : it->second)
+        {
+            ret.push_back(&entries[idx]);
+        }
+    }
+    return ret;
+}
+
+auto FirmwareCatalog::FindModel(const std::string &model) const -> std::vector<const CatalogEntry *>
+{
+    std::vector<const CatalogEntry *> ret;
+    auto it = by_model.find(model);
+    if (it != by_model.end())
+    {
+        for (const auto &idx : it->second)
+        {
+            ret.push_back(&entries[idx]);
+        }
+    }
+    return ret;
+}
+
+auto FirmwareCatalog::Identify(const std::string &file) const -> std::vector<const CatalogEntry *>
+{
+    auto mf = MappedFile::Open(file);
+    return FindDigest(digest::SHA256::Hash(mf->GetData(), mf->GetSize()));
+}
@@ -0,0 +1,114 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <radio_tool/fw/fw_factory.hpp>
+
+#include <fstream>
+#include <cstring>
+#include <unordered_map>
+
+using namespace radio_tool::fw;
+
+/**
+ * Handlers are indexed by the first 4 bytes of their magic
+ */
+typedef std::unordered_map<uint32_t, std::vector<const FirmwareSupportTest *>> MagicTable;
+
+static auto MagicKey(const uint8_t *data) -> uint32_t
+{
+    uint32_t ret;
+    memcpy(&ret, data, sizeof(ret));
+    return ret;
+}
+
+static auto GetMagicTable() -> const MagicTable &
+{
+    static const auto table = []() {
+        MagicTable ret;
+        for (const auto &h : AllFirmwareHandlers)
+        {
+            if (h.Magic.size() >= sizeof(uint32_t))
+            {
+                ret[MagicKey(h.Magic.data())].push_back(&h);
+            }
+        }
+        return ret;
+    }();
+    return table;
+}
+
+auto FirmwareFactory::ReadPrefix(const std::string &file, std::vector<uint8_t> &prefix) -> uint64_t
+{
+    std::ifstream i(file, std::ios_base::binary | std::ios_base::ate);
+    if (!i.is_open())
+    {
+        throw std::runtime_error("Can't open firmware file");
+    }
+
+    auto size = static_cast<uint64_t>(i.tellg());
+    prefix.resize(std::min<uint64_t>(size, SniffSize));
+    i.seekg(0, i.beg);
+    i.read((char *)prefix.data(), prefix.size());
+    return size;
+}
+
+auto FirmwareFactory::GetFirmwareHandler(const ByteView &header, const uint64_t &file_size) -> const FirmwareSupportTest &
+{
+    if (header.size() >= sizeof(uint32_t))
+    {
+        const auto &table = GetMagicTable();
+        auto it = table.find(MagicKey(header.data()));
+        if (it != table.end())
+        {
+            for (const auto &h : it->second)
+            {
+                if (header.size() >= h->Magic.size()
+                    && std::equal(h->Magic.begin(), h->Magic.end(), header.begin())
+                    && h->SupportsFirmwareFile(header, file_size))
+                {
+                    return *h;
+                }
+            }
+        }
+    }
+
+    //formats without a magic can only be tested one by one
+    for (const auto &h : AllFirmwareHandlers)
+    {
+        if (h.Magic.empty() && h.SupportsFirmwareFile(header, file_size))
+        {
+            return h;
+        }
+    }
+    throw std::runtime_error("Firmware file not supported");
+}
+
+auto FirmwareFactory::GetFirmwareFileHandler(const std::string &file) -> std::unique_ptr<FirmwareSupport>
+{
+    std::vector<uint8_t> prefix;
+    auto size = ReadPrefix(file, prefix);
+    return GetFirmwareHandler(ByteView(prefix), size).CreateHandler();
+}
+
+auto FirmwareFactory::GetFirmwareFileInfo(const std::string &file) -> std::unique_ptr<FirmwareSupport>
+{
+    std::vector<uint8_t> prefix;
+    auto size = ReadPrefix(file, prefix);
+    auto ret = GetFirmwareHandler(ByteView(prefix), size).CreateHandler();
+    ret->ReadHeader(ByteView(prefix), size);
+    return ret;
+}
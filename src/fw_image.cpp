@@ -0,0 +1,222 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <radio_tool/fw/fw_image.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace radio_tool::fw;
+
+auto FirmwareImage::Find(const uint32_t &addr) const -> std::map<uint32_t, Extent>::const_iterator
+{
+    auto it = extents.upper_bound(addr);
+    if (it == extents.begin())
+    {
+        return extents.end();
+    }
+    --it;
+    return addr - it->first < it->second.Bytes().size() ? it : extents.end();
+}
+
+auto FirmwareImage::Overlaps(const uint32_t &addr, const size_t &len) const -> bool
+{
+    if (len == 0)
+    {
+        return false;
+    }
+
+    //the last extent starting before the end is the only one which can overlap
+    auto end = static_cast<uint64_t>(addr) + len;
+    auto it = extents.lower_bound(static_cast<uint32_t>(std::min<uint64_t>(end, UINT32_MAX)));
+    if (end > UINT32_MAX && it != extents.end())
+    {
+        return true;
+    }
+    if (it == extents.begin())
+    {
+        return false;
+    }
+    --it;
+    return it->first + static_cast<uint64_t>(it->second.Bytes().size()) > addr;
+}
+
+auto FirmwareImage::Contains(const uint32_t &addr, const size_t &len) const -> bool
+{
+    auto it = Find(addr);
+    return it != extents.end() && len <= it->second.Bytes().size() - (addr - it->first);
+}
+
+auto FirmwareImage::Add(const uint32_t &addr, const ByteView &data) -> void
+{
+    if (data.empty())
+    {
+        return;
+    }
+    if (static_cast<uint64_t>(addr) + data.size() > static_cast<uint64_t>(UINT32_MAX) + 1)
+    {
+        throw std::runtime_error("Segment is outside the address space");
+    }
+    if (Overlaps(addr, data.size()))
+    {
+        throw std::runtime_error("Segment overlaps another segment");
+    }
+    extents[addr].view = data;
+}
+
+auto FirmwareImage::Write(const uint32_t &addr, const ByteView &data) -> void
+{
+    if (data.empty())
+    {
+        return;
+    }
+    auto end = static_cast<uint64_t>(addr) + data.size();
+    if (end > static_cast<uint64_t>(UINT32_MAX) + 1)
+    {
+        throw std::runtime_error("Write is outside the address space");
+    }
+
+    //in place if a single extent already holds every byte
+    auto it = Find(addr);
+    if (it != extents.end() && Contains(addr, data.size()))
+    {
+        auto &ext = extents[it->first];
+        if (ext.owned.empty())
+        {
+            ext.owned.assign(ext.view.begin(), ext.view.end());
+            ext.view = ByteView();
+        }
+        std::copy(data.begin(), data.end(), ext.owned.begin() + (addr - it->first));
+        return;
+    }
+
+    //otherwise merge every extent touching [addr, end) into one
+    auto first = extents.lower_bound(addr);
+    if (first != extents.begin())
+    {
+        auto prev = std::prev(first);
+        if (prev->first + static_cast<uint64_t>(prev->second.Bytes().size()) >= addr)
+        {
+            first = prev;
+        }
+    }
+    auto last = end > UINT32_MAX ? extents.end() : extents.upper_bound(static_cast<uint32_t>(end));
+
+    auto start = std::min<uint32_t>(addr, first != last ? first->first : addr);
+    auto new_end = end;
+    for (auto x = first; x != last; ++x)
+    {
+        new_end = std::max<uint64_t>(new_end, x->first + static_cast<uint64_t>(x->second.Bytes().size()));
+    }
+
+    Extent merged;
+    merged.owned.resize(new_end - start);
+    for (auto x = first; x != last; ++x)
+    {
+        auto bytes = x->second.Bytes();
+        std::copy(bytes.begin(), bytes.end(), merged.owned.begin() + (x->first - start));
+    }
+    std::copy(data.begin(), data.end(), merged.owned.begin() + (addr - start));
+
+    extents.erase(first, last);
+    extents[start] = std::move(merged);
+}
+
+auto FirmwareImage::Read(const uint32_t &addr, const size_t &len) const -> ByteView
+{
+    auto it = Find(addr);
+    if (it == extents.end())
+    {
+        throw std::out_of_range("Address is not in the firmware image");
+    }
+    auto bytes = it->second.Bytes();
+    if (len > bytes.size() - (addr - it->first))
+    {
+        throw std::out_of_range("Read crosses the end of a segment");
+    }
+    return bytes.Sub(addr - it->first, len);
+}
+
+auto FirmwareImage::Merge() -> void
+{
+    for (auto it = extents.begin(); it != extents.end();)
+    {
+        auto next = std::next(it);
+        if (next == extents.end() || it->first + static_cast<uint64_t>(it->second.Bytes().size()) != next->first)
+        {
+            it = next;
+            continue;
+        }
+
+        auto &ext = it->second;
+        if (ext.owned.empty())
+        {
+            ext.owned.assign(ext.view.begin(), ext.view.end());
+            ext.view = ByteView();
+        }
+        auto bytes = next->second.Bytes();
+        ext.owned.insert(ext.owned.end(), bytes.begin(), bytes.end());
+        extents.erase(next);
+    }
+}
+
+auto FirmwareImage::Flatten(const uint32_t &start, const uint64_t &end, const uint8_t &fill) const -> std::vector<uint8_t>
+{
+    if (end < start)
+    {
+        throw std::out_of_range("Invalid flatten range");
+    }
+
+    std::vector<uint8_t> ret(end - start, fill);
+    auto it = extents.upper_bound(start);
+    if (it != extents.begin())
+    {
+        --it;
+    }
+    for (; it != extents.end() && it->first < end; ++it)
+    {
+        auto bytes = it->second.Bytes();
+        auto from = std::max<uint64_t>(it->first, start);
+        auto to = std::min<uint64_t>(it->first + static_cast<uint64_t>(bytes.size()), end);
+        if (from < to)
+        {
+            std::copy(bytes.begin() + (from - it->first), bytes.begin() + (to - it->first), ret.begin() + (from - start));
+        }
+    }
+    return ret;
+}
+
+auto FirmwareImage::GetExtents() const -> std::vector<std::pair<uint32_t, ByteView>>
+{
+    std::vector<std::pair<uint32_t, ByteView>> ret;
+    ret.reserve(extents.size());
+    for (const auto &e : extents)
+    {
+        ret.push_back({e.first, e.second.Bytes()});
+    }
+    return ret;
+}
+
+auto FirmwareImage::GetSize() const -> uint64_t
+{
+    uint64_t ret = 0;
+    for (const auto &e : extents)
+    {
+        ret += e.second.Bytes().size();
+    }
+    return ret;
+}
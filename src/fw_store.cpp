@@ -0,0 +1,328 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <radio_tool/fw/fw_store.hpp>
+#include <radio_tool/fw/fw_factory.hpp>
+#include <radio_tool/fw/cipher/cipher.hpp>
+#include <radio_tool/util/mapped_file.hpp>
+
+#include <array>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+
+using namespace radio_tool::fw;
+
+namespace fs = std::filesystem;
+
+/**
+ * First line of each recipe, bump the version when the format changes
+ */
+constexpr auto RecipeMagic = "radio_tool-store 1";
+
+/**
+ * Random values for the gear rolling hash (splitmix64), fixed so chunk boundaries never change
+ */
+static auto GetGearTable() -> const std::array<uint64_t, 256> &
+{
+    static const auto table = []() {
+        std::array<uint64_t, 256> ret;
+        uint64_t x = 0x9e3779b97f4a7c15;
+        for (auto &v : ret)
+        {
+            x += 0x9e3779b97f4a7c15;
+            auto z = x;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+            v = z ^ (z >> 31);
+        }
+        return ret;
+    }();
+    return table;
+}
+
+/**
+ * Find the key of a keystream so it can be recreated from the recipe
+ */
+static auto GetCipherName(const radio_tool::keystream::CipherStream &cs) -> std::string
+{
+    for (const auto &c : cipher::AllCiphers)
+    {
+        if (c.length == cs.GetKeyLength() && memcmp(c.key, cs.GetKey(), c.length) == 0)
+        {
+            return c.name;
+        }
+    }
+    throw std::runtime_error("Unknown cipher");
+}
+
+static auto GetCipherByName(const std::string &name) -> const cipher::CipherInfo &
+{
+    for (const auto &c : cipher::AllCiphers)
+    {
+        if (name == c.name)
+        {
+            return c;
+        }
+    }
+    throw std::runtime_error("Unknown cipher: " + name);
+}
+
+FirmwareStore::FirmwareStore(const std::string &dir)
+    : dir(dir)
+{
+    fs::create_directories(fs::path(dir) / "chunks");
+    fs::create_directories(fs::path(dir) / "files");
+}
+
+auto FirmwareStore::Chunk(const ByteView &data) -> std::vector<size_t>
+{
+    const auto &gear = GetGearTable();
+    std::vector<size_t> ret;
+    for (size_t start = 0; start < data.size();)
+    {
+        auto left = data.size() - start;
+        auto n = std::min(left, MaxChunkSize);
+        if (left > MinChunkSize)
+        {
+            //only the last 64 bytes affect the hash, so start just before the minimum size
+            uint64_t h = 0;
+            for (auto x = MinChunkSize - 64; x < n; x++)
+            {
+                h = (h << 1) + gear[data[start + x]];
+                if (x + 1 >= MinChunkSize && (h & AvgChunkMask) == 0)
+                {
+                    n = x + 1;
+                    break;
+                }
+            }
+        }
+        ret.push_back(n);
+        start += n;
+    }
+    return ret;
+}
+
+auto FirmwareStore::GetRecipePath(const std::string &name) const -> std::string
+{
+    if (name.empty() || name.find_first_of("/\\\t\n") != name.npos || name == "." || name == "..")
+    {
+        throw std::invalid_argument("Invalid store name: " + name);
+    }
+    return (fs::path(dir) / "files" / name).string();
+}
+
+auto FirmwareStore::GetChunkPath(const digest::SHA256Digest &id) const -> std::string
+{
+    auto hex = digest::ToHex(id);
+    return (fs::path(dir) / "chunks" / hex.substr(0, 2) / hex).string();
+}
+
+auto FirmwareStore::PutChunk(const ByteView &data, digest::SHA256Digest &id) const -> bool
+{
+    id = digest::SHA256::Hash(data.data(), data.size());
+    auto path = GetChunkPath(id);
+
+    std::error_code ec;
+    if (fs::exists(path, ec))
+    {
+        return false;
+    }
+
+    fs::create_directories(fs::path(path).parent_path());
+    auto tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios_base::binary);
+        out.write((const char *)data.data(), data.size());
+        if (!out)
+        {
+            throw std::runtime_error("Failed to write file");
+        }
+    }
+    fs::rename(tmp, path);
+    return true;
+}
+
+auto FirmwareStore::Add(const std::string &file, const std::string &name) const -> uint64_t
+{
+    auto recipe_path = GetRecipePath(name);
+
+    auto fw = FirmwareFactory::GetFirmwareFileHandler(file);
+    fw->Read(file);
+    auto mf = MappedFile::Open(file);
+    auto whole = ByteView(mf->GetData(), mf->GetSize());
+
+    auto data_offset = fw->GetDataOffset();
+    auto data_size = fw->GetData().size();
+    if (data_offset + data_size > whole.size())
+    {
+        throw std::runtime_error("Invalid firmware file");
+    }
+
+    std::stringstream recipe;
+    recipe << RecipeMagic << "\n"
+           << "sha256 " << digest::ToHex(digest::SHA256::Hash(whole.data(), whole.size())) << "\n"
+           << "size " << whole.size() << "\n"
+           << "cipher " << GetCipherName(fw->GetCipher()) << "\n";
+
+    uint64_t written = 0;
+    auto put = [&](const char *type, const ByteView &part) {
+        if (part.empty())
+        {
+            return;
+        }
+        digest::SHA256Digest id;
+        if (PutChunk(part, id))
+        {
+            written += part.size();
+        }
+        recipe << type << " " << digest::ToHex(id) << " " << part.size() << "\n";
+    };
+
+    //header as is, binary decrypted in chunks, footer as is
+    put("raw", whole.Sub(0, data_offset));
+
+    fw->Decrypt();
+    auto plain = ByteView(fw->GetData().data(), data_size);
+    size_t offset = 0;
+    for (const auto &n : Chunk(plain))
+    {
+        put("data", plain.Sub(offset, n));
+        offset += n;
+    }
+
+    put("raw", whole.Sub(data_offset + data_size, whole.size() - data_offset - data_size));
+
+    auto tmp = recipe_path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios_base::trunc);
+        out << recipe.str();
+        if (!out)
+        {
+            throw std::runtime_error("Failed to write file");
+        }
+    }
+    fs::rename(tmp, recipe_path);
+    return written;
+}
+
+auto FirmwareStore::Extract(const std::string &name, const std::string &out) const -> void
+{
+    std::ifstream in(GetRecipePath(name));
+    std::string line;
+    if (!in.is_open() || !std::getline(in, line) || line != RecipeMagic)
+    {
+        throw std::runtime_error("Not found in store: " + name);
+    }
+
+    std::string expect_sha, cipher_name;
+    uint64_t expect_size = 0;
+    std::vector<std::pair<std::string, std::pair<std::string, uint64_t>>> parts;
+    while (std::getline(in, line))
+    {
+        std::stringstream ss(line);
+        std::string key;
+        ss >> key;
+        if (key == "sha256")
+        {
+            ss >> expect_sha;
+        }
+        else if (key == "size")
+        {
+            ss >> expect_size;
+        }
+        else if (key == "cipher")
+        {
+            ss >> cipher_name;
+        }
+        else if (key == "raw" || key == "data")
+        {
+            std::string id;
+            uint64_t len = 0;
+            ss >> id >> len;
+            parts.push_back({key, {id, len}});
+        }
+    }
+
+    auto cipher = GetCipherByName(cipher_name).make(0);
+    digest::SHA256 sha;
+    uint64_t size = 0;
+
+    //out only appears once the rebuilt file is verified
+    auto tmp = out + ".tmp";
+    try
+    {
+        std::ofstream fout(tmp, std::ios_base::binary);
+        if (!fout.is_open())
+        {
+            throw std::runtime_error("Cant open file");
+        }
+
+        std::vector<uint8_t> buf;
+        for (const auto &p : parts)
+        {
+            auto chunk = MappedFile::Open((fs::path(dir) / "chunks" / p.second.first.substr(0, 2) / p.second.first).string());
+            if (chunk->GetSize() != p.second.second)
+            {
+                throw std::runtime_error("Damaged chunk: " + p.second.first);
+            }
+
+            buf.assign(chunk->GetData(), chunk->GetData() + chunk->GetSize());
+            if (p.first == "data")
+            {
+                cipher.Apply(buf.data(), buf.size());
+            }
+            sha.Update(buf.data(), buf.size());
+            fout.write((const char *)buf.data(), buf.size());
+            size += buf.size();
+        }
+        fout.close();
+        if (!fout)
+        {
+            throw std::runtime_error("Failed to write file");
+        }
+
+        if (size != expect_size || digest::ToHex(sha.Finalize()) != expect_sha)
+        {
+            throw std::runtime_error("Rebuilt file does not match the original: " + name);
+        }
+    }
+    catch (...)
+    {
+        std::error_code ec;
+        fs::remove(tmp, ec);
+        throw;
+    }
+    fs::rename(tmp, out);
+}
+
+auto FirmwareStore::List() const -> std::vector<std::string>
+{
+    std::vector<std::string> ret;
+    for (const auto &e : fs::directory_iterator(fs::path(dir) / "files"))
+    {
+        //skip recipes which are still being written
+        if (e.is_regular_file() && e.path().extension() != ".tmp")
+        {
+            ret.push_back(e.path().filename().string());
+        }
+    }
+    std::sort(ret.begin(), ret.end());
+    return ret;
+}
@@ -0,0 +1,85 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <radio_tool/fw/fw_view.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace radio_tool::fw;
+
+auto DecryptedView::GetPage(const uint64_t &page) const -> ByteView
+{
+    auto start = page * PageSize;
+    if (start >= encrypted.size())
+    {
+        throw std::out_of_range("Page is outside the image");
+    }
+
+    use_counter++;
+    for (auto &c : cache)
+    {
+        if (c.page == page)
+        {
+            c.last_use = use_counter;
+            return ByteView(c.data);
+        }
+    }
+
+    //reuse the least recently used page once the cache is full
+    CachedPage *slot;
+    if (cache.size() < CachePages)
+    {
+        slot = &cache.emplace_back();
+    }
+    else
+    {
+        slot = &*std::min_element(cache.begin(), cache.end(), [](const CachedPage &a, const CachedPage &b) {
+            return a.last_use < b.last_use;
+        });
+    }
+
+    auto src = encrypted.Sub(start, std::min<uint64_t>(PageSize, encrypted.size() - start));
+    slot->page = page;
+    slot->last_use = use_counter;
+    slot->data.assign(src.begin(), src.end());
+    cipher.ApplyAt(start, slot->data.data(), slot->data.size());
+    return ByteView(slot->data);
+}
+
+auto DecryptedView::Read(const uint64_t &offset, uint8_t *out, const size_t &len) const -> void
+{
+    if (offset > encrypted.size() || len > encrypted.size() - offset)
+    {
+        throw std::out_of_range("Read is outside the image");
+    }
+
+    for (auto pos = offset; pos < offset + len;)
+    {
+        auto page = GetPage(pos / PageSize);
+        auto in_page = pos % PageSize;
+        auto n = std::min<uint64_t>(page.size() - in_page, offset + len - pos);
+        std::copy_n(page.begin() + in_page, n, out + (pos - offset));
+        pos += n;
+    }
+}
+
+auto DecryptedView::ReadAddress(const uint32_t &addr, uint8_t *out, const size_t &len) const -> void
+{
+    auto src = image.Read(addr, len);
+    Read(src.data() - encrypted.data(), out, len);
+}
@@ -0,0 +1,113 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <radio_tool/fw/fw_wrap.hpp>
+#include <radio_tool/fw/fw_factory.hpp>
+#include <radio_tool/fw/tyt_fw.hpp>
+#include <radio_tool/util/thread_pool.hpp>
+
+#include <algorithm>
+#include <sstream>
+#include <typeinfo>
+
+using namespace radio_tool::fw;
+
+auto FirmwareWrap::ExpandTargets(const std::string &radios) -> std::vector<std::string>
+{
+    std::vector<std::string> ret;
+    auto add = [&ret](const std::string &radio) {
+        if (std::find(ret.begin(), ret.end(), radio) == ret.end())
+        {
+            ret.push_back(radio);
+        }
+    };
+
+    std::stringstream ss(radios);
+    std::string name;
+    while (std::getline(ss, name, ','))
+    {
+        if (name.empty())
+        {
+            continue;
+        }
+
+        auto family = false;
+        for (const auto &r : tyt::config::Radios)
+        {
+            if (name == r.firmware_model)
+            {
+                add(r.radio_model);
+                family = true;
+            }
+        }
+        if (!family)
+        {
+            add(name);
+        }
+    }
+    return ret;
+}
+
+auto FirmwareWrap::GetOutputName(const std::string &out, const std::string &radio) -> std::string
+{
+    auto suffix = "_" + radio;
+    std::replace(suffix.begin(), suffix.end(), ' ', '_');
+
+    auto name_start = out.find_last_of("/\\");
+    auto ext = out.find_last_of('.');
+    if (ext == out.npos || ext == 0 || (name_start != out.npos && ext <= name_start + 1))
+    {
+        return out + suffix;
+    }
+    return out.substr(0, ext) + suffix + out.substr(ext);
+}
+
+auto FirmwareWrap::Run(const std::vector<WrapTarget> &targets, const std::vector<std::pair<uint32_t, ByteView>> &segments) -> void
+{
+    if (targets.empty())
+    {
+        return;
+    }
+
+    std::vector<std::unique_ptr<FirmwareSupport>> fws;
+    for (const auto &t : targets)
+    {
+        auto fw = FirmwareFactory::GetFirmwareModelHandler(t.radio);
+        fw->SetRadioModel(t.radio);
+        if (!fws.empty() && typeid(*fw) != typeid(*fws.front()))
+        {
+            throw std::runtime_error("Radio " + t.radio + " uses a different firmware format to " + targets.front().radio);
+        }
+        fws.push_back(std::move(fw));
+    }
+
+    //the padded plaintext is shared, each target only copies it to encrypt
+    auto plain = FirmwareFactory::GetFirmwareModelHandler(targets.front().radio);
+    plain->SetSegments(segments);
+    std::vector<std::pair<uint32_t, ByteView>> padded;
+    for (const auto &s : plain->GetDataSegments())
+    {
+        padded.push_back({s.address, s.data});
+    }
+
+    thread::ThreadPool::Shared().ParallelFor(fws.size(), [&](const size_t &idx) {
+        auto &fw = fws[idx];
+        fw->SetSegments(padded);
+        fw->Encrypt();
+        fw->Write(targets[idx].file);
+    });
+}
@@ -0,0 +1,193 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <radio_tool/util/gather_writer.hpp>
+
+#include <array>
+#include <cerrno>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/uio.h>
+#endif
+
+using namespace radio_tool;
+
+/**
+ * Size of the constant fill blocks, larger fills reference the block many times
+ */
+constexpr auto FillBlockSize = 0x1000u;
+
+template <uint8_t V>
+static auto FillBlock() -> const std::array<uint8_t, FillBlockSize> &
+{
+    static const auto block = []() {
+        std::array<uint8_t, FillBlockSize> ret;
+        ret.fill(V);
+        return ret;
+    }();
+    return block;
+}
+
+auto GatherWriter::Add(const ByteView &data) -> void
+{
+    if (!data.empty())
+    {
+        pieces.push_back(data);
+    }
+}
+
+auto GatherWriter::AddCopy(const void *data, const size_t &len) -> void
+{
+    auto p = (const uint8_t *)data;
+    owned.emplace_back(p, p + len);
+    Add(ByteView(owned.back().data(), len));
+}
+
+auto GatherWriter::AddFill(const uint8_t &value, const size_t &len) -> void
+{
+    const uint8_t *block = nullptr;
+    if (value == 0xff)
+    {
+        block = FillBlock<0xff>().data();
+    }
+    else if (value == 0x00)
+    {
+        block = FillBlock<0x00>().data();
+    }
+    else
+    {
+        owned.emplace_back(std::min<size_t>(len, FillBlockSize), value);
+        block = owned.back().data();
+    }
+
+    for (size_t done = 0; done < len;)
+    {
+        auto n = std::min<size_t>(len - done, FillBlockSize);
+        Add(ByteView(block, n));
+        done += n;
+    }
+}
+
+auto GatherWriter::GetSize() const -> uint64_t
+{
+    uint64_t ret = 0;
+    for (const auto &p : pieces)
+    {
+        ret += p.size();
+    }
+    return ret;
+}
+
+auto GatherWriter::Write(const std::string &file) const -> void
+{
+    //pieces may reference a mapping of file itself (rewriting a firmware in place),
+    //so never truncate the target before everything has been written
+    auto tmp = file + ".tmp";
+    try
+    {
+        WritePieces(tmp);
+    }
+    catch (const std::exception &)
+    {
+        std::error_code ec;
+        std::filesystem::remove(tmp, ec);
+        throw;
+    }
+    std::filesystem::rename(tmp, file);
+}
+
+auto GatherWriter::WritePieces(const std::string &file) const -> void
+{
+#ifdef _WIN32
+    std::ofstream fout(file, std::ios_base::binary);
+    if (!fout.is_open())
+    {
+        throw std::runtime_error("Cant open file");
+    }
+    for (const auto &p : pieces)
+    {
+        fout.write((const char *)p.data(), p.size());
+    }
+    if (!fout)
+    {
+        throw std::runtime_error("Failed to write file");
+    }
+#else
+    auto fd = open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Cant open file");
+    }
+
+#ifdef IOV_MAX
+    constexpr size_t MaxIOV = IOV_MAX;
+#else
+    constexpr size_t MaxIOV = 1024;
+#endif
+
+    std::vector<iovec> iov;
+    iov.reserve(std::min(pieces.size(), MaxIOV));
+    for (size_t idx = 0; idx < pieces.size();)
+    {
+        iov.clear();
+        for (; idx < pieces.size() && iov.size() < MaxIOV; idx++)
+        {
+            iov.push_back({(void *)pieces[idx].data(), pieces[idx].size()});
+        }
+
+        //writev may stop early, skip over whatever was written and retry
+        auto cur = iov.data();
+        auto left = iov.size();
+        while (left > 0)
+        {
+            auto w = writev(fd, cur, (int)left);
+            if (w < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (w < 0)
+            {
+                close(fd);
+                throw std::runtime_error("Failed to write file");
+            }
+            auto n = (size_t)w;
+            while (left > 0 && n >= cur->iov_len)
+            {
+                n -= cur->iov_len;
+                cur++;
+                left--;
+            }
+            if (left > 0)
+            {
+                cur->iov_base = (uint8_t *)cur->iov_base + n;
+                cur->iov_len -= n;
+            }
+        }
+    }
+    if (close(fd) != 0)
+    {
+        throw std::runtime_error("Failed to write file");
+    }
+#endif
+}
@@ -0,0 +1,472 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <radio_tool/util/keystream.hpp>
+#include <radio_tool/util/cpu.hpp>
+#include <radio_tool/util/thread_pool.hpp>
+
+#include <atomic>
+#include <algorithm>
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef RADIO_TOOL_X86
+#include <immintrin.h>
+#endif
+
+using namespace radio_tool::keystream;
+
+namespace radio_tool::keystream
+{
+    /**
+     * Kernel signatures, ext is the key starting at the first keystream byte
+     * and extended by at least one period plus MaxVectorSize bytes so any vector
+     * load starting inside the key period can read straight through the wrap point
+     */
+    typedef void (*XORKernel)(uint8_t *data, size_t len, const uint8_t *ext, uint32_t key_len);
+    typedef uint64_t (*SumKernel)(const uint8_t *data, size_t len, const uint8_t *ext, uint32_t key_len);
+
+    class KernelSet
+    {
+    public:
+        const char *name;
+        XORKernel xor_fn;
+        SumKernel sum_fn;
+    };
+} // namespace radio_tool::keystream
+
+namespace
+{
+    /**
+     * Largest vector width of any kernel, the expanded key is padded by this much
+     */
+    constexpr auto MaxVectorSize = 64u;
+
+    /**
+     * Below this size its not worth expanding the key
+     */
+    constexpr auto MinVectorLength = 128u;
+
+
+    /**
+     * Advance the keystream position by one block, wrapping at the end of the key period
+     * @note KeyLen is the key length for kernels specialized on a power of two key, 0 for any length
+     */
+    template <uint32_t KeyLen>
+    inline auto NextPos(size_t pos, const size_t &block, const uint32_t &key_len) -> size_t
+    {
+        if constexpr (KeyLen != 0)
+        {
+            static_assert((KeyLen & (KeyLen - 1)) == 0 && KeyLen % MaxVectorSize == 0, "Fixed key length must be a power of two multiple of the vector size");
+            return (pos + block) & (KeyLen - 1);
+        }
+        else
+        {
+            pos += block;
+            return pos >= key_len ? pos % key_len : pos;
+        }
+    }
+
+    /**
+     * XOR the bytes which dont fill a whole block
+     */
+    inline auto XORTail(uint8_t *data, const size_t &len, const uint8_t *ext) -> void
+    {
+        for (size_t i = 0; i < len; i++)
+        {
+            data[i] ^= ext[i];
+        }
+    }
+
+    /**
+     * Sum the XOR of the bytes which dont fill a whole block
+     */
+    inline auto SumTail(const uint8_t *data, const size_t &len, const uint8_t *ext) -> uint64_t
+    {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < len; i++)
+        {
+            sum += data[i] ^ ext[i];
+        }
+        return sum;
+    }
+
+    template <uint32_t KeyLen>
+    auto XORScalar(uint8_t *data, size_t len, const uint8_t *ext, uint32_t key_len) -> void
+    {
+        size_t pos = 0, i = 0;
+        RADIO_TOOL_UNROLL
+        for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t))
+        {
+            uint64_t a, b;
+            memcpy(&a, data + i, sizeof(a));
+            memcpy(&b, ext + pos, sizeof(b));
+            a ^= b;
+            memcpy(data + i, &a, sizeof(a));
+            pos = NextPos<KeyLen>(pos, sizeof(uint64_t), key_len);
+        }
+        XORTail(data + i, len - i, ext + pos);
+    }
+
+    template <uint32_t KeyLen>
+    auto SumScalar(const uint8_t *data, size_t len, const uint8_t *ext, uint32_t key_len) -> uint64_t
+    {
+        size_t pos = 0, i = 0;
+        uint64_t sum = 0;
+        RADIO_TOOL_UNROLL
+        for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t))
+        {
+            uint64_t a, b;
+            memcpy(&a, data + i, sizeof(a));
+            memcpy(&b, ext + pos, sizeof(b));
+            a ^= b;
+            //add the 8 bytes pairwise so no lane can overflow
+            a = (a & 0x00ff00ff00ff00ffull) + ((a >> 8) & 0x00ff00ff00ff00ffull);
+            a = (a & 0x0000ffff0000ffffull) + ((a >> 16) & 0x0000ffff0000ffffull);
+            sum += (a & 0xffffffffull) + (a >> 32);
+            pos = NextPos<KeyLen>(pos, sizeof(uint64_t), key_len);
+        }
+        return sum + SumTail(data + i, len - i, ext + pos);
+    }
+
+#ifdef RADIO_TOOL_X86
+    template <uint32_t KeyLen>
+    RADIO_TOOL_TARGET("sse2")
+    auto XORSSE2(uint8_t *data, size_t len, const uint8_t *ext, uint32_t key_len) -> void
+    {
+        size_t pos = 0, i = 0;
+        RADIO_TOOL_UNROLL
+        for (; i + sizeof(__m128i) <= len; i += sizeof(__m128i))
+        {
+            auto a = _mm_loadu_si128((const __m128i *)(data + i));
+            auto b = _mm_loadu_si128((const __m128i *)(ext + pos));
+            _mm_storeu_si128((__m128i *)(data + i), _mm_xor_si128(a, b));
+            pos = NextPos<KeyLen>(pos, sizeof(__m128i), key_len);
+        }
+        XORTail(data + i, len - i, ext + pos);
+    }
+
+    template <uint32_t KeyLen>
+    RADIO_TOOL_TARGET("sse2")
+    auto SumSSE2(const uint8_t *data, size_t len, const uint8_t *ext, uint32_t key_len) -> uint64_t
+    {
+        size_t pos = 0, i = 0;
+        auto zero = _mm_setzero_si128();
+        auto acc = _mm_setzero_si128();
+        RADIO_TOOL_UNROLL
+        for (; i + sizeof(__m128i) <= len; i += sizeof(__m128i))
+        {
+            auto a = _mm_loadu_si128((const __m128i *)(data + i));
+            auto b = _mm_loadu_si128((const __m128i *)(ext + pos));
+            acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_xor_si128(a, b), zero));
+            pos = NextPos<KeyLen>(pos, sizeof(__m128i), key_len);
+        }
+        uint64_t lanes[2];
+        _mm_storeu_si128((__m128i *)lanes, acc);
+        return lanes[0] + lanes[1] + SumTail(data + i, len - i, ext + pos);
+    }
+
+    template <uint32_t KeyLen>
+    RADIO_TOOL_TARGET("avx2")
+    auto XORAVX2(uint8_t *data, size_t len, const uint8_t *ext, uint32_t key_len) -> void
+    {
+        size_t pos = 0, i = 0;
+        RADIO_TOOL_UNROLL
+        for (; i + sizeof(__m256i) <= len; i += sizeof(__m256i))
+        {
+            auto a = _mm256_loadu_si256((const __m256i *)(data + i));
+            auto b = _mm256_loadu_si256((const __m256i *)(ext + pos));
+            _mm256_storeu_si256((__m256i *)(data + i), _mm256_xor_si256(a, b));
+            pos = NextPos<KeyLen>(pos, sizeof(__m256i), key_len);
+        }
+        XORTail(data + i, len - i, ext + pos);
+    }
+
+    template <uint32_t KeyLen>
+    RADIO_TOOL_TARGET("avx2")
+    auto SumAVX2(const uint8_t *data, size_t len, const uint8_t *ext, uint32_t key_len) -> uint64_t
+    {
+        size_t pos = 0, i = 0;
+        auto zero = _mm256_setzero_si256();
+        auto acc = _mm256_setzero_si256();
+        RADIO_TOOL_UNROLL
+        for (; i + sizeof(__m256i) <= len; i += sizeof(__m256i))
+        {
+            auto a = _mm256_loadu_si256((const __m256i *)(data + i));
+            auto b = _mm256_loadu_si256((const __m256i *)(ext + pos));
+            acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_xor_si256(a, b), zero));
+            pos = NextPos<KeyLen>(pos, sizeof(__m256i), key_len);
+        }
+        uint64_t lanes[4];
+        _mm256_storeu_si256((__m256i *)lanes, acc);
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3] + SumTail(data + i, len - i, ext + pos);
+    }
+
+    template <uint32_t KeyLen>
+    RADIO_TOOL_TARGET("avx512f")
+    auto XORAVX512(uint8_t *data, size_t len, const uint8_t *ext, uint32_t key_len) -> void
+    {
+        size_t pos = 0, i = 0;
+        RADIO_TOOL_UNROLL
+        for (; i + sizeof(__m512i) <= len; i += sizeof(__m512i))
+        {
+            auto a = _mm512_loadu_si512((const void *)(data + i));
+            auto b = _mm512_loadu_si512((const void *)(ext + pos));
+            _mm512_storeu_si512((void *)(data + i), _mm512_xor_si512(a, b));
+            pos = NextPos<KeyLen>(pos, sizeof(__m512i), key_len);
+        }
+        XORTail(data + i, len - i, ext + pos);
+    }
+
+    template <uint32_t KeyLen>
+    RADIO_TOOL_TARGET("avx512f,avx512bw")
+    auto SumAVX512(const uint8_t *data, size_t len, const uint8_t *ext, uint32_t key_len) -> uint64_t
+    {
+        size_t pos = 0, i = 0;
+        auto zero = _mm512_setzero_si512();
+        auto acc = _mm512_setzero_si512();
+        RADIO_TOOL_UNROLL
+        for (; i + sizeof(__m512i) <= len; i += sizeof(__m512i))
+        {
+            auto a = _mm512_loadu_si512((const void *)(data + i));
+            auto b = _mm512_loadu_si512((const void *)(ext + pos));
+            acc = _mm512_add_epi64(acc, _mm512_sad_epu8(_mm512_xor_si512(a, b), zero));
+            pos = NextPos<KeyLen>(pos, sizeof(__m512i), key_len);
+        }
+        //fold the two 256 bit halves, the unmasked extracts (and _mm512_reduce_add_epi64) start from
+        //_mm256_undefined_si256 which trips -Wuninitialized on gcc 12
+        auto zero256 = _mm256_setzero_si256();
+        auto half = _mm256_add_epi64(_mm512_mask_extracti64x4_epi64(zero256, 0xff, acc, 0),
+                                     _mm512_mask_extracti64x4_epi64(zero256, 0xff, acc, 1));
+        uint64_t lanes[4];
+        _mm256_storeu_si256((__m256i *)lanes, half);
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3] + SumTail(data + i, len - i, ext + pos);
+    }
+#endif
+
+    template <uint32_t KeyLen>
+    auto SelectKernel() -> KernelSet
+    {
+#ifdef RADIO_TOOL_X86
+        const auto &cpu = radio_tool::cpu::GetFeatures();
+        if (cpu.avx512f && cpu.avx512bw)
+        {
+            return {"avx512", XORAVX512<KeyLen>, SumAVX512<KeyLen>};
+        }
+        if (cpu.avx2)
+        {
+            return {"avx2", XORAVX2<KeyLen>, SumAVX2<KeyLen>};
+        }
+        if (cpu.sse2)
+        {
+            return {"sse2", XORSSE2<KeyLen>, SumSSE2<KeyLen>};
+        }
+#endif
+        return {"scalar", XORScalar<KeyLen>, SumScalar<KeyLen>};
+    }
+
+    /**
+     * Kernels for this CPU, KeyLen = 0 for keys of any length
+     */
+    template <uint32_t KeyLen>
+    auto GetKernel() -> const KernelSet *
+    {
+        static const auto kernel = SelectKernel<KeyLen>();
+        return &kernel;
+    }
+
+    /**
+     * Pick kernels specialized on the key length if there are any
+     */
+    auto GetKernel(const uint32_t &key_len) -> const KernelSet *
+    {
+        switch (key_len)
+        {
+        case 0x100:
+            return GetKernel<0x100>();
+        case 0x400:
+            return GetKernel<0x400>();
+        default:
+            return GetKernel<0>();
+        }
+    }
+
+    /**
+     * Smallest range given to a single thread
+     */
+    constexpr size_t MinParallelRange = 0x40000;
+
+    std::atomic<unsigned> thread_limit(0);
+
+    /**
+     * Split len bytes into key period aligned ranges for the thread pool,
+     * returns the range size or 0 if the buffer should be done on this thread
+     */
+    auto ParallelRangeSize(const size_t &len, const uint32_t &key_len) -> size_t
+    {
+        if (len < ParallelThreshold)
+        {
+            return 0;
+        }
+
+        auto &pool = radio_tool::thread::ThreadPool::Shared();
+        auto limit = thread_limit.load();
+        auto threads = std::min<size_t>(limit == 0 ? pool.GetThreadCount() + 1 : limit, len / MinParallelRange);
+        if (threads < 2)
+        {
+            return 0;
+        }
+
+        //round up to whole key periods so every range starts at the same key position
+        auto range = (len + threads - 1) / threads;
+        return ((range + key_len - 1) / key_len) * key_len;
+    }
+
+} // namespace
+
+CipherStream::CipherStream(const uint8_t *key, const uint32_t &key_len, const uint64_t &offset)
+    : key(key), key_len(key_len), offset(offset), kernel(GetKernel(key_len))
+{
+    if (key_len == 0)
+    {
+        throw std::invalid_argument("XOR key cannot be empty");
+    }
+
+    //two periods plus one vector, so a kernel can start anywhere in the first period
+    ext.resize((key_len * 2) + MaxVectorSize);
+    for (size_t i = 0; i < ext.size(); i++)
+    {
+        ext[i] = key[i % key_len];
+    }
+}
+
+auto CipherStream::Apply(uint8_t *data, const size_t &len) -> void
+{
+    ApplyAt(offset, data, len);
+    offset += len;
+}
+
+auto CipherStream::ApplyAt(const uint64_t &at, uint8_t *data, const size_t &len) const -> void
+{
+    auto fn = kernel->xor_fn;
+    auto k = ext.data() + (at % key_len);
+    auto range = ParallelRangeSize(len, key_len);
+    if (range == 0)
+    {
+        fn(data, len, k, key_len);
+        return;
+    }
+
+    radio_tool::thread::ThreadPool::Shared().ParallelFor((len + range - 1) / range, [&](const size_t &idx) {
+        auto start = idx * range;
+        fn(data + start, std::min(range, len - start), k, key_len);
+    });
+}
+
+auto CipherStream::Sum(const uint8_t *data, const size_t &len) -> uint64_t
+{
+    auto ret = SumAt(offset, data, len);
+    offset += len;
+    return ret;
+}
+
+auto CipherStream::SumAt(const uint64_t &at, const uint8_t *data, const size_t &len) const -> uint64_t
+{
+    auto fn = kernel->sum_fn;
+    auto k = ext.data() + (at % key_len);
+    auto range = ParallelRangeSize(len, key_len);
+    if (range == 0)
+    {
+        return fn(data, len, k, key_len);
+    }
+
+    std::atomic<uint64_t> sum(0);
+    radio_tool::thread::ThreadPool::Shared().ParallelFor((len + range - 1) / range, [&](const size_t &idx) {
+        auto start = idx * range;
+        sum += fn(data + start, std::min(range, len - start), k, key_len);
+    });
+    return sum.load();
+}
+
+template <uint32_t KeyLen>
+auto CipherStream::Fixed(const uint8_t *key, const uint64_t &offset) -> CipherStream
+{
+    auto ret = CipherStream(key, KeyLen, offset);
+    ret.kernel = GetKernel<KeyLen>();
+    return ret;
+}
+
+template auto CipherStream::Fixed<0x100>(const uint8_t *, const uint64_t &) -> CipherStream;
+template auto CipherStream::Fixed<0x400>(const uint8_t *, const uint64_t &) -> CipherStream;
+
+auto radio_tool::keystream::Apply(uint8_t *data, const size_t &len, const uint8_t *key, const uint32_t &key_len, const uint32_t &key_offset) -> void
+{
+    if (len >= MinVectorLength)
+    {
+        CipherStream(key, key_len, key_offset).Apply(data, len);
+        return;
+    }
+    if (key_len == 0)
+    {
+        throw std::invalid_argument("XOR key cannot be empty");
+    }
+
+    auto offset = key_offset % key_len;
+    for (size_t i = 0; i < len; i++)
+    {
+        data[i] ^= key[offset++];
+        if (offset == key_len)
+        {
+            offset = 0;
+        }
+    }
+}
+
+auto radio_tool::keystream::Sum(const uint8_t *data, const size_t &len, const uint8_t *key, const uint32_t &key_len, const uint32_t &key_offset) -> uint64_t
+{
+    if (len >= MinVectorLength)
+    {
+        return CipherStream(key, key_len, key_offset).Sum(data, len);
+    }
+    if (key_len == 0)
+    {
+        throw std::invalid_argument("XOR key cannot be empty");
+    }
+
+    auto offset = key_offset % key_len;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        sum += data[i] ^ key[offset++];
+        if (offset == key_len)
+        {
+            offset = 0;
+        }
+    }
+    return sum;
+}
+
+auto radio_tool::keystream::SetThreadLimit(const unsigned &threads) -> void
+{
+    thread_limit = threads;
+}
+
+auto radio_tool::keystream::GetKernelName() -> const char *
+{
+    return GetKernel<0>()->name;
+}
@@ -0,0 +1,119 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <radio_tool/util/mapped_file.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using namespace radio_tool;
+
+auto MappedFile::Open(const std::string &file) -> std::shared_ptr<const MappedFile>
+{
+    auto ret = std::shared_ptr<MappedFile>(new MappedFile());
+#ifdef _WIN32
+    auto fh = CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fh == INVALID_HANDLE_VALUE)
+    {
+        throw std::runtime_error("Cant open file");
+    }
+    ret->file_handle = fh;
+
+    LARGE_INTEGER size = {};
+    if (GetFileSizeEx(fh, &size) && size.QuadPart > 0)
+    {
+        auto mh = CreateFileMappingA(fh, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mh != nullptr)
+        {
+            ret->map_handle = mh;
+            auto view = MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0);
+            if (view != nullptr)
+            {
+                ret->ptr = (const uint8_t *)view;
+                ret->len = (size_t)size.QuadPart;
+                ret->mapped = true;
+                return ret;
+            }
+        }
+    }
+#else
+    auto fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Cant open file");
+    }
+
+    struct stat st = {};
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+    {
+        auto view = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view != MAP_FAILED)
+        {
+            close(fd);
+            ret->ptr = (const uint8_t *)view;
+            ret->len = (size_t)st.st_size;
+            ret->mapped = true;
+            return ret;
+        }
+    }
+    close(fd);
+#endif
+
+    //empty or unmappable (e.g. a pipe), read it instead
+    std::ifstream in(file, std::ios_base::binary);
+    if (!in.is_open())
+    {
+        throw std::runtime_error("Cant open file");
+    }
+    ret->fallback.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    ret->ptr = ret->fallback.data();
+    ret->len = ret->fallback.size();
+    return ret;
+}
+
+MappedFile::~MappedFile()
+{
+    if (mapped)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(ptr);
+#else
+        munmap((void *)ptr, len);
+#endif
+    }
+#ifdef _WIN32
+    if (map_handle != nullptr)
+    {
+        CloseHandle(map_handle);
+    }
+    if (file_handle != nullptr)
+    {
+        CloseHandle(file_handle);
+    }
+#endif
+}
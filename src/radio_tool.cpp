@@ -22,10 +22,14 @@
 #include <radio_tool/dfu/dfu_exception.hpp>
 #include <radio_tool/util.hpp>
 #include <radio_tool/version.hpp>
-
-#ifdef XOR_TOOL
-#include <xor_tool.hpp>
-#endif
+#include <radio_tool/fw/xor_tool.hpp>
+#include <radio_tool/fw/fw_batch.hpp>
+#include <radio_tool/fw/fw_catalog.hpp>
+#include <radio_tool/fw/fw_store.hpp>
+#include <radio_tool/fw/fw_wrap.hpp>
+#include <radio_tool/util/elf.hpp>
+#include <radio_tool/util/flash.hpp>
+#include <radio_tool/util/mapped_file.hpp>
 
 #include <iostream>
 #include <filesystem>
@@ -70,6 +74,8 @@ int main(int argc, char **argv)
 
         options.add_options("Programming")
             ("f,flash", "Flash firmware")
+            ("delta", "Only flash sectors which changed since the last --flash --delta of this radio, needs a USB serial number or --radio-id")
+            ("radio-id", "Identity of this radio unit for --delta, e.g. the serial number on its label", cxxopts::value<std::string>(), "<id>")
             ("p,program", "Upload codeplug");
         
         options.add_options("All radio")
@@ -87,17 +93,22 @@ int main(int argc, char **argv)
         options.add_options("Firmware")
             ("fw-info", "Print info about a firmware file")
             ("wrap", "Wrap a firmware bin (use --help wrap, for more info)")
-#ifdef XOR_TOOL
-            ("make-xor", "Try to make an XOR key for the input firmware")        
-#endif
-            ("unwrap", "Unwrap a fimrware file");
+            ("make-xor", "Try to make an XOR key for the input firmware")
+            ("digest", "Print CRC32/SHA-256 of the decrypted segments with --fw-info")
+            ("unwrap", "Unwrap a fimrware file")
+            ("batch", "Run --fw-info/--unwrap on many files, one JSON record per line (-o is the output directory)", cxxopts::value<std::vector<std::string>>(), "<dir|glob>")
+            ("j,jobs", "Number of files to process at once with --batch", cxxopts::value<unsigned>()->default_value("0"), "<n>")
+            ("store", "Deduplicating firmware store, add -i/--batch files, rebuild with --extract or list", cxxopts::value<std::string>(), "<dir>")
+            ("extract", "Rebuild a file from --store to -o", cxxopts::value<std::string>(), "<name>")
+            ("catalog", "Update the index of a firmware directory, find images with -i <file> or -r <radio>", cxxopts::value<std::string>(), "<dir>");
 
         options.add_options("Codeplug")
             ("codeplug-info", "Print info about a codeplug file");
 
         options.add_options("Wrap")
             ("s,segment", "Add a segment for wrapping", cxxopts::value<std::vector<std::string>>(), "<0x08000000:region_0.bin>")
-            ("r,radio", "Radio to build firmware file for", cxxopts::value<std::string>(), "<DM1701>");
+            ("e,elf", "Wrap the loadable segments of an ELF file instead of -s", cxxopts::value<std::string>(), "<firmware.elf>")
+            ("r,radio", "Radio to build firmware file for, a comma separated list (or firmware model e.g. MD-9600) builds each one to -o with the radio added to the name", cxxopts::value<std::string>(), "<DM1701>");
 
         auto cmd = options.parse(argc, argv);
 
@@ -136,13 +147,120 @@ int main(int argc, char **argv)
         }
 
         //do non device specific commands
+        if (cmd.count("store"))
+        {
+            FirmwareStore store(cmd["store"].as<std::string>());
+            if (cmd.count("extract"))
+            {
+                auto out_file = GetOptionOrErr<std::string>(cmd, "out", "Output file not specified");
+                store.Extract(cmd["extract"].as<std::string>(), out_file);
+                exit(0);
+            }
+
+            std::vector<std::string> files;
+            if (cmd.count("in"))
+            {
+                files.push_back(cmd["in"].as<std::string>());
+            }
+            if (cmd.count("batch"))
+            {
+                auto more = FirmwareBatch::ExpandInputs(cmd["batch"].as<std::vector<std::string>>());
+                files.insert(files.end(), more.begin(), more.end());
+            }
+
+            if (files.empty())
+            {
+                for (const auto &name : store.List())
+                {
+                    std::cout << name << std::endl;
+                }
+                exit(0);
+            }
+
+            for (const auto &f : files)
+            {
+                auto name = std::filesystem::path(f).filename().string();
+                auto added = store.Add(f, name);
+                std::cerr << name << ": " << std::dec << std::filesystem::file_size(f) << " bytes, " << added << " new" << std::endl;
+            }
+            exit(0);
+        }
+
+        if (cmd.count("batch"))
+        {
+            BatchOptions opt;
+            if (cmd.count("unwrap"))
+            {
+                opt.op = BatchOp::Unwrap;
+                opt.out_dir = GetOptionOrErr<std::string>(cmd, "out", "Output directory not specified");
+            }
+            else if (!cmd.count("fw-info"))
+            {
+                throw std::invalid_argument("--batch needs --fw-info or --unwrap");
+            }
+            opt.digest = cmd.count("digest") > 0;
+            opt.jobs = cmd["jobs"].as<unsigned>();
+
+            auto files = FirmwareBatch::ExpandInputs(cmd["batch"].as<std::vector<std::string>>());
+            auto failed = FirmwareBatch::Run(files, opt, [](const BatchRecord &rec) {
+                std::cout << rec.ToJSON() << std::endl;
+            });
+            exit(failed > 0 ? 1 : 0);
+        }
+
+        if (cmd.count("catalog"))
+        {
+            FirmwareCatalog catalog(cmd["catalog"].as<std::string>());
+            auto updated = catalog.Update();
+            catalog.Save();
+
+            auto print = [](const CatalogEntry *e) {
+                std::cout << radio_tool::digest::ToHex(e->sha256) << "  " << (e->IsFirmware() ? e->model : "-") << "  " << e->path << std::endl;
+            };
+            if (cmd.count("in"))
+            {
+                auto found = catalog.Identify(cmd["in"].as<std::string>());
+                std::for_each(found.begin(), found.end(), print);
+                exit(found.empty() ? 1 : 0);
+            }
+            if (cmd.count("radio"))
+            {
+                auto found = catalog.FindModel(cmd["radio"].as<std::string>());
+                std::for_each(found.begin(), found.end(), print);
+                exit(0);
+            }
+
+            auto n_fw = std::count_if(catalog.GetEntries().begin(), catalog.GetEntries().end(), [](const CatalogEntry &e) {
+                return e.IsFirmware();
+            });
+            std::cerr << "Indexed " << catalog.GetEntries().size() << " files (" << updated << " updated), "
+                      << n_fw << " firmware images" << std::endl;
+            exit(0);
+        }
+
         if (cmd.count("fw-info"))
         {
             auto file = GetOptionOrErr<std::string>(cmd, "in", "Input file not specified");
             
+            //the header is enough for the summary, digests need the whole image
+            if (!cmd.count("digest"))
+            {
+                std::cerr << FirmwareFactory::GetFirmwareFileInfo(file)->ToString();
+                exit(0);
+            }
+
             auto fw = FirmwareFactory::GetFirmwareFileHandler(file);
             fw->Read(file);
             std::cerr << fw->ToString();
+            fw->Decrypt();
+            std::cerr << "Digests (decrypted):" << std::endl;
+            for (const auto &s : fw->GetDataSegments())
+            {
+                std::cerr << "  " << s.index << ": CRC32=" << std::setfill('0') << std::setw(8) << std::hex << s.GetCRC32()
+                          << ", SHA256=" << radio_tool::digest::ToHex(s.GetSHA256()) << std::endl;
+            }
+            std::cerr << "  *: CRC32=" << std::setfill('0') << std::setw(8) << std::hex << fw->GetCRC32()
+                      << ", SHA256=" << radio_tool::digest::ToHex(fw->GetSHA256()) << std::endl;
             exit(0);
         }
 
@@ -160,10 +278,64 @@ int main(int argc, char **argv)
         {
             auto out = GetOptionOrErr<std::string>(cmd, "out", "Output file not specified");
             auto radio = GetOptionOrErr<std::string>(cmd, "radio", "Radio not specified");
+            auto radios = FirmwareWrap::ExpandTargets(radio);
+            if(radios.empty())
+            {
+                throw std::invalid_argument("Radio not specified");
+            }
+
+            //several radios share the padded segments, each is encrypted and written in parallel
+            auto wrap_all = [&out, &radios](const std::vector<std::pair<uint32_t, radio_tool::ByteView>> &segs) {
+                std::vector<WrapTarget> targets;
+                for(const auto &r : radios)
+                {
+                    targets.push_back({r, FirmwareWrap::GetOutputName(out, r)});
+                    std::cerr << "Building " << r << " to " << targets.back().file << std::endl;
+                }
+                FirmwareWrap::Run(targets, segs);
+                std::cerr << "Done!" << std::endl;
+                exit(0);
+            };
+
+            auto fw = FirmwareFactory::GetFirmwareModelHandler(radios.front());
+            fw->SetRadioModel(radios.front());
+
+            if(cmd.count("elf"))
+            {
+                //segments are copied straight from the mapped ELF into the image
+                auto elf = radio_tool::elf::ElfFile::Open(cmd["elf"].as<std::string>());
+                FirmwareImage elf_image;
+                for(const auto &seg : elf.GetLoadSegments())
+                {
+                    auto end = static_cast<uint64_t>(seg.address) + seg.data.size();
+                    if(!radio_tool::flash::FlashUtil::InMap(radio_tool::flash::STM32F40X, seg.address, static_cast<uint32_t>(end)))
+                    {
+                        std::stringstream msg;
+                        msg << "ELF segment 0x" << std::hex << seg.address << "-0x" << end << " is outside the flash map";
+                        throw std::runtime_error(msg.str());
+                    }
+
+                    std::cerr << "Adding segment 0x"
+                        << std::hex << std::setw(8) << std::setfill('0') << seg.address
+                        << " [Size=0x" << seg.data.size() << "] from ELF" << std::endl;
+                    elf_image.Add(seg.address, seg.data);
+                }
+                if(radios.size() > 1)
+                {
+                    wrap_all(elf_image.GetExtents());
+                }
+                fw->SetImage(elf_image);
+
+                fw->Encrypt();
+                fw->Write(out);
+                std::cerr << "Done!" << std::endl;
+                exit(0);
+            }
+
             auto segments = GetOptionOrErr<std::vector<std::string>>(cmd, "segment", "Must specify at least 1 segment");
 
-            auto fw = FirmwareFactory::GetFirmwareModelHandler(radio);
-            fw->SetRadioModel(radio);
+            //segment files are streamed into the output, not loaded
+            std::vector<std::pair<uint32_t, std::string>> seg_files;
             for(const auto &sx : segments)
             {
                 auto schar = sx.find(':');
@@ -185,24 +357,7 @@ int main(int argc, char **argv)
                         << std::hex << std::setw(8) << std::setfill('0') << addr
                         << " from file " << filename << std::endl;
 
-                    std::ifstream f_seg(filename, std::ios_base::binary);
-                    if(f_seg.is_open())
-                    {
-                        f_seg.seekg(0, f_seg.end);
-                        auto len = f_seg.tellg();
-                        f_seg.seekg(0, f_seg.beg);
-
-                        std::vector<uint8_t> seg_data;
-                        seg_data.resize(len);
-                        f_seg.read((char*)seg_data.data(), len);
-                        f_seg.close();
-
-                        fw->AppendSegment(addr, seg_data);
-                    }
-                    else 
-                    {
-                        throw std::runtime_error("Cant open file for segment");
-                    }
+                    seg_files.push_back({addr, filename});
                 }
                 else 
                 {
@@ -210,8 +365,19 @@ int main(int argc, char **argv)
                 }
             }
 
-            fw->Encrypt();
-            fw->Write(out);
+            if(radios.size() > 1)
+            {
+                std::vector<std::shared_ptr<const radio_tool::MappedFile>> files;
+                std::vector<std::pair<uint32_t, radio_tool::ByteView>> file_segments;
+                for(const auto &sf : seg_files)
+                {
+                    files.push_back(radio_tool::MappedFile::Open(sf.second));
+                    file_segments.push_back({sf.first, radio_tool::ByteView(files.back()->GetData(), files.back()->GetSize())});
+                }
+                wrap_all(file_segments);
+            }
+
+            fw->WriteSegments(out, seg_files);
             std::cerr << "Done!" << std::endl;
             exit(0);
         }
@@ -223,51 +389,33 @@ int main(int argc, char **argv)
             
             auto fw_handler = FirmwareFactory::GetFirmwareFileHandler(in_file);
             fw_handler->Read(in_file);
-            fw_handler->Decrypt();
-
-            for(const auto& rn : fw_handler->GetDataSegments()) 
-            {
-                std::stringstream ss_name;
-                ss_name << out_file << "_0x" << std::setw(8) << std::setfill('0') << std::hex << rn.address;
 
-                std::ofstream fw_out;
-                fw_out.open(ss_name.str(), std::ios_base::out | std::ios_base::binary);
-                if(fw_out.is_open()) 
-                {
-                    fw_out.write((const char*)rn.data.data(), rn.data.size());
-                    fw_out.close();
-                } 
-                else 
-                {
-                    std::cerr << "Failed to open output file: " << out_file << std::endl;
-                    exit(1);
-                }
-            }
+            fw_handler->UnwrapSegments(out_file);
             exit(0);
         }
 
-#ifdef XOR_TOOL
         if(cmd.count("make-xor")) 
         {
             auto in_file = GetOptionOrErr<std::string>(cmd, "in", "Input file not specified");          
             auto fw_handler = FirmwareFactory::GetFirmwareFileHandler(in_file);
             fw_handler->Read(in_file);
             
-            auto key = radio_tool::fw::XORTool::MakeXOR(fw_handler->GetData());
+            auto key = radio_tool::fw::XORTool::MakeXOR(*fw_handler);
+            auto r_offset = 0u;
             for(const auto& region : fw_handler->GetDataSegments()) 
             {
-                if(radio_tool::fw::XORTool::Verify(region.address, region.data, key))
+                if(radio_tool::fw::XORTool::Verify(region.address, region.data, key, r_offset))
                 {
                     std::cout 
                         << "Region @ 0x" << std::setfill('0') << std::setw(8) << std::hex << region.address
                         << " appears to be a valid vector_table" << std::endl;
                 }
+                r_offset += region.size;
             }
 
             radio_tool::PrintHex(key.begin(), key.end());
             exit(0);
         }
-#endif
         
         auto rdFactory = RadioFactory();
         if (cmd.count("list"))
@@ -298,7 +446,17 @@ int main(int argc, char **argv)
         if(cmd.count("flash")) 
         {
             auto in_file = GetOptionOrErr<std::string>(cmd, "in", "Input file not specified");
-            radio->WriteFirmware(in_file);
+            std::optional<std::string> delta_id;
+            if(cmd.count("delta"))
+            {
+                //the ledger must identify this unit, not the model, or another radio's image is used as the base
+                delta_id = cmd.count("radio-id") ? cmd["radio-id"].as<std::string>() : dfu.GetSerialNumber();
+                if(delta_id->empty())
+                {
+                    throw std::invalid_argument("--delta needs --radio-id, this radio has no USB serial number");
+                }
+            }
+            radio->WriteFirmware(in_file, delta_id);
             std::cout << "Done!" << std::endl;
         }
 
@@ -0,0 +1,161 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <radio_tool/util/thread_pool.hpp>
+
+#include <atomic>
+#include <memory>
+#include <exception>
+
+using namespace radio_tool::thread;
+
+ThreadPool::ThreadPool(const unsigned &threads)
+    : stop(false)
+{
+    auto n = threads != 0 ? threads : std::thread::hardware_concurrency();
+    if (n == 0)
+    {
+        n = 1;
+    }
+
+    for (auto x = 0u; x < n; x++)
+    {
+        workers.emplace_back(&ThreadPool::Worker, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        stop = true;
+    }
+    signal.notify_all();
+    for (auto &w : workers)
+    {
+        w.join();
+    }
+}
+
+auto ThreadPool::Worker() -> void
+{
+    while (true)
+    {
+        std::packaged_task<void()> task;
+        {
+            std::unique_lock<std::mutex> lk(lock);
+            signal.wait(lk, [this] { return stop || !queue.empty(); });
+            if (stop && queue.empty())
+            {
+                return;
+            }
+            task = std::move(queue.front());
+            queue.pop_front();
+        }
+        task();
+    }
+}
+
+auto ThreadPool::Submit(std::function<void()> &&fn) -> std::future<void>
+{
+    auto task = std::packaged_task<void()>(std::move(fn));
+    auto ret = task.get_future();
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        queue.push_back(std::move(task));
+    }
+    signal.notify_one();
+    return ret;
+}
+
+namespace
+{
+    /**
+     * State shared between the caller of ParallelFor and its helper tasks,
+     * helpers which start after all the work is taken just exit so the caller
+     * never waits on a task which is stuck in the queue
+     */
+    class ParallelState
+    {
+    public:
+        ParallelState(const size_t &count, const std::function<void(const size_t &)> *fn)
+            : count(count), fn(fn), next(0), done(0) {}
+
+        const size_t count;
+        const std::function<void(const size_t &)> *fn;
+        std::atomic<size_t> next, done;
+        std::mutex lock;
+        std::condition_variable signal;
+        std::exception_ptr error;
+
+        auto Run() -> void
+        {
+            size_t idx;
+            while ((idx = next.fetch_add(1)) < count)
+            {
+                try
+                {
+                    (*fn)(idx);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lk(lock);
+                    if (!error)
+                    {
+                        error = std::current_exception();
+                    }
+                }
+
+                if (done.fetch_add(1) + 1 == count)
+                {
+                    std::lock_guard<std::mutex> lk(lock);
+                    signal.notify_all();
+                }
+            }
+        }
+    };
+} // namespace
+
+auto ThreadPool::ParallelFor(const size_t &count, const std::function<void(const size_t &)> &fn) -> void
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    auto state = std::make_shared<ParallelState>(count, &fn);
+    auto helpers = std::min<size_t>(count - 1, workers.size());
+    for (auto x = 0u; x < helpers; x++)
+    {
+        Submit([state] { state->Run(); });
+    }
+
+    state->Run();
+
+    std::unique_lock<std::mutex> lk(state->lock);
+    state->signal.wait(lk, [&state] { return state->done.load() == state->count; });
+    if (state->error)
+    {
+        std::rethrow_exception(state->error);
+    }
+}
+
+auto ThreadPool::Shared() -> ThreadPool &
+{
+    static ThreadPool pool;
+    return pool;
+}
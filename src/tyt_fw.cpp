@@ -16,100 +16,141 @@
  * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
  */
 #include <radio_tool/fw/tyt_fw.hpp>
+#include <radio_tool/fw/cipher/detect.hpp>
 #include <radio_tool/util.hpp>
+#include <radio_tool/util/gather_writer.hpp>
 
 using namespace radio_tool::fw;
 
 auto TYTFW::Read(const std::string &file) -> void
 {
-    const auto HeaderSize = 0x100;
+    auto f = MappedFile::Open(file);
+    ReadHeader(ByteView(f->GetData(), std::min<uint64_t>(f->GetSize(), HeaderSize)), f->GetSize());
 
-    auto i = std::ifstream(file, std::ios_base::binary);
-    if (i.is_open())
-    {
-        auto header = ReadHeader(i);
-        CheckHeader(header);
-
-        firmware_model = std::string(header.radio, header.radio + strlen((const char *)header.radio));
-        counterMagic = std::vector<uint8_t>(header.counter_magic, header.counter_magic + 1 + header.counter_magic[0]);
-        radio_model = GetRadioFromMagic(counterMagic);
+    //reference the binary in place, pages are only read when used
+    data.Map(f, HeaderSize, GetImageSize());
+    InvalidateCache();
 
-        auto binarySize = 0;
-        for (auto nMem = 0; nMem < header.n_regions; nMem++)
+    //unknown counter magic, try to find the key from the data
+    if (!cipherKey)
+    {
+        auto best = cipher::CipherDetect::Detect(cipher::CipherDetect::MakeSamples(*this),
+                                                 {cipher::CipherKey::MD380, cipher::CipherKey::MD9600, cipher::CipherKey::UV3X0, cipher::CipherKey::DM1701});
+        if (best)
         {
-            uint32_t rStart = 0, rLength = 0;
-            i.read((char *)&rStart, 4);
-            i.read((char *)&rLength, 4);
-            memory_ranges.push_back(std::make_pair(rStart, rLength));
-            binarySize += rLength;
+            cipherKey = best->cipher->id;
         }
+    }
 
-        //skip to binary
-        i.seekg(HeaderSize);
+    //meh ignore footer
+}
 
-        data.resize(binarySize);
-        i.read((char *)data.data(), data.size());
+auto TYTFW::ReadHeader(const ByteView &buf, const uint64_t &file_size) -> void
+{
+    auto header = ParseHeader(buf);
+    CheckHeader(header);
+
+    firmware_model = std::string(header.radio, header.radio + strnlen((const char *)header.radio, sizeof(header.radio)));
+    SetCounterMagic(std::vector<uint8_t>(header.counter_magic, header.counter_magic + 1 + header.counter_magic[0]));
+    auto known = tyt::config::FindByMagic(tyt::magic::PackCounterMagic(header.counter_magic, 1 + header.counter_magic[0]));
+    radio_model = known != nullptr ? known->radio_model : UnknownRadio;
 
-        //meh ignore footer
+    //region table follows the header
+    if (header.n_regions > (buf.size() - sizeof(TYTFirmwareHeader)) / 8)
+    {
+        throw std::runtime_error("Invalid firmware file");
     }
-    i.close();
+    uint64_t binarySize = 0;
+    memory_ranges.clear();
+    for (auto nMem = 0u; nMem < header.n_regions; nMem++)
+    {
+        uint32_t rStart = 0, rLength = 0;
+        memcpy(&rStart, buf.data() + sizeof(TYTFirmwareHeader) + nMem * 8, 4);
+        memcpy(&rLength, buf.data() + sizeof(TYTFirmwareHeader) + nMem * 8 + 4, 4);
+        memory_ranges.push_back(std::make_pair(rStart, rLength));
+        binarySize += rLength;
+    }
+    if (HeaderSize + binarySize > file_size)
+    {
+        throw std::runtime_error("Invalid firmware file");
+    }
+    InvalidateCache();
 }
 
 auto TYTFW::Write(const std::string &file) -> void
 {
-    std::ofstream fout(file, std::ios_base::binary);
-    if(fout.is_open())
-    {
-        //make header
-        TYTFirmwareHeader h = {};
-        h.n1 = 0x30000230;
-        h.n2 = 0x47004000;
-        std::copy(tyt::magic::begin.begin(), tyt::magic::begin.end(), h.magic);
-        std::copy(firmware_model.begin(), firmware_model.end(), h.radio);
-        for(auto cx = 0; cx < 76; cx++)
-        {
-            if(cx > 0x20) 
-            {
-                h.counter_magic[cx] = 0xff;
-            } 
-            else 
-            {
-                h.counter_magic[cx] = cx;
-            }
-        }
-        std::copy(counterMagic.begin(), counterMagic.end(), h.counter_magic);
-        h.n_regions = memory_ranges.size();
+    auto header = MakeHeader();
+
+    //header + region info, firmware data, footer padding, end magic
+    GatherWriter out;
+    out.Add(ByteView(header));
+    out.Add(ByteView(data.data(), data.size()));
+    out.AddFill(0xff, FooterPadding);
+    out.Add(ByteView(tyt::magic::end.data(), tyt::magic::end.size()));
+    out.Write(file);
+}
 
-        //write the header
-        fout.write((char*)&h, sizeof(TYTFirmwareHeader));
+auto TYTFW::WriteSegments(const std::string &file, const std::vector<std::pair<uint32_t, std::string>> &segments) -> void
+{
+    PlanSegments(segments);
+    auto header = MakeHeader();
 
-        //write region info
-        for(const auto &rx : memory_ranges)
-        {
-            fout.write((char*)&rx.first, sizeof(uint32_t));
-            fout.write((char*)&rx.second, sizeof(uint32_t));
-        }
+    std::ofstream out(file, std::ios_base::binary);
+    if (!out.is_open())
+    {
+        throw std::runtime_error("Cant open file");
+    }
+    out.write((const char *)header.data(), header.size());
+    StreamSegments(out, segments);
 
-        //add padding
-        for(auto pad_x = 0; pad_x < 0x80 - (sizeof(uint32_t) * memory_ranges.size() * 2); pad_x++)
-        {
-            fout.put(0xff);
-        }
+    const std::vector<uint8_t> footer(FooterPadding, 0xff);
+    out.write((const char *)footer.data(), footer.size());
+    out.write((const char *)tyt::magic::end.data(), tyt::magic::end.size());
+    if (!out)
+    {
+        throw std::runtime_error("Failed to write file");
+    }
+}
 
-        //write firmware data
-        fout.write((char*)data.data(), data.size());
+auto TYTFW::MakeHeader() const -> std::vector<uint8_t>
+{
+    //region table and its padding share the space after the header
+    if (memory_ranges.size() * sizeof(uint32_t) * 2 > HeaderSize - sizeof(TYTFirmwareHeader))
+    {
+        throw std::runtime_error("Too many memory ranges for TYT header");
+    }
 
-        //add footer padding
-        for(auto pad_end = 0; pad_end < 0x100 - 16; pad_end++)
+    TYTFirmwareHeader h = {};
+    h.n1 = 0x30000230;
+    h.n2 = 0x47004000;
+    std::copy(tyt::magic::begin.begin(), tyt::magic::begin.end(), h.magic);
+    std::copy(firmware_model.begin(), firmware_model.end(), h.radio);
+    for(auto cx = 0; cx < 76; cx++)
+    {
+        if(cx > 0x20) 
+        {
+            h.counter_magic[cx] = 0xff;
+        } 
+        else 
         {
-            fout.put(0xff);
+            h.counter_magic[cx] = cx;
         }
+    }
+    std::copy(counterMagic.begin(), counterMagic.end(), h.counter_magic);
+    h.n_regions = memory_ranges.size();
 
-        //add end magic
-        fout.write((char*)tyt::magic::end.data(), tyt::magic::end.size());
+    std::vector<uint8_t> ret(HeaderSize, 0xff);
+    memcpy(ret.data(), &h, sizeof(TYTFirmwareHeader));
 
-        fout.close();
+    //write region info
+    auto rx_offset = sizeof(TYTFirmwareHeader);
+    for(const auto &rx : memory_ranges)
+    {
+        memcpy(ret.data() + rx_offset, &rx.first, sizeof(uint32_t));
+        memcpy(ret.data() + rx_offset + 4, &rx.second, sizeof(uint32_t));
+        rx_offset += 8;
     }
+    return ret;
 }
 
 auto TYTFW::ToString() const -> std::string
@@ -117,7 +158,8 @@ auto TYTFW::ToString() const -> std::string
     std::stringstream out;
     out << "== TYT Firmware == " << std::endl
         << "Radio: " << firmware_model << " (" << radio_model << ")" << std::endl
-        << "Size:  " << std::fixed << std::setprecision(2) << (data.size() / 1024.0) << " KiB" << std::endl
+        << "Size:  " << std::fixed << std::setprecision(2) << (GetImageSize() / 1024.0) << " KiB" << std::endl
+        << "Cipher: " << (cipherKey ? cipher::GetCipherInfo(*cipherKey).name : "unknown") << std::endl
         << "Data Segments: " << std::endl;
     auto n = 0;
     for (const auto &m : memory_ranges)
@@ -129,11 +171,15 @@ auto TYTFW::ToString() const -> std::string
     return out.str();
 }
 
-auto TYTFW::ReadHeader(std::ifstream &i) -> TYTFirmwareHeader
+auto TYTFW::ParseHeader(const ByteView &buf) -> TYTFirmwareHeader
 {
+    if (buf.size() < HeaderSize)
+    {
+        throw std::runtime_error("Invalid firmware file");
+    }
+
     TYTFirmwareHeader ret = {};
-    i.seekg(0, i.beg);
-    i.read((char *)&ret, sizeof(TYTFirmwareHeader));
+    memcpy(&ret, buf.data(), sizeof(TYTFirmwareHeader));
 
     if (ret.n_regions == std::numeric_limits<uint32_t>::max())
     {
@@ -150,88 +196,51 @@ auto TYTFW::CheckHeader(const TYTFirmwareHeader &header) -> void
         throw std::runtime_error("Invalid start magic");
     }
 
-    if (header.counter_magic[0] > 3)
+    //unknown counter magics are accepted, Read detects the key from the data
+    if (header.counter_magic[0] == 0 || header.counter_magic[0] > 3)
     {
         throw std::runtime_error("Invalid counter magic length");
     }
 
-    auto magic_match = false;
-    for (const auto &r : tyt::config::All)
-    {
-        //header.counter_magic should always be longer than r.second
-        if (std::equal(r.counter_magic.begin(), r.counter_magic.end(), header.counter_magic))
-        {
-            magic_match = true;
-            break;
-        }
-    }
-    if (!magic_match)
-    {
-        throw std::runtime_error("Counter magic is invalid, or not supported");
-    }
-
-    uint32_t binarySize = 0;
-    if ((header.n_regions * 8) > 0x80)
+    if (header.n_regions > (HeaderSize - sizeof(TYTFirmwareHeader)) / 8)
     {
         throw std::runtime_error("Memory region count out of bounds");
     }
 }
 
-auto TYTFW::SupportsFirmwareFile(const std::string &file) -> bool
+auto TYTFW::SupportsFirmwareFile(const ByteView &header, const uint64_t &) -> bool
 {
-    std::ifstream i;
-    i.open(file, i.binary);
-    if (i.is_open())
+    try
     {
-        auto header = ReadHeader(i);
-        i.close();
-
-        try
-        {
-            CheckHeader(header);
-        }
-        catch (std::exception&)
-        {
-            return false;
-        }
-
-        return true;
+        CheckHeader(ParseHeader(header));
     }
-    else
+    catch (std::exception&)
     {
-        throw std::runtime_error("Can't open firmware file");
+        return false;
     }
+    return true;
 }
 
 auto TYTFW::SupportsRadioModel(const std::string &model) -> bool
 {
-    for(const auto &mx : tyt::config::All)
-    {
-        if(mx.radio_model == model)
-        {
-            return true;
-        }
-    }
-    return false;
+    return tyt::config::FindByModel(model) != nullptr;
 }
 
 auto TYTFW::GetRadioModel() const -> const std::string
 {
-    return GetRadioFromMagic(counterMagic);
+    auto r = tyt::config::FindByMagic(tyt::magic::PackCounterMagic(counterMagic.data(), counterMagic.size()));
+    return r != nullptr ? r->radio_model : UnknownRadio;
 }
 
 
 auto TYTFW::SetRadioModel(const std::string &model) -> void
 {
-    for(const auto &rg : tyt::config::All)
+    auto rg = tyt::config::FindByModel(model);
+    if (rg != nullptr)
     {
-        if(rg.radio_model == model)
-        {
-            counterMagic = rg.counter_magic;
-            radio_model = rg.radio_model;
-            firmware_model = rg.firmware_model;
-            break;
-        }
+        SetCounterMagic(tyt::magic::UnpackCounterMagic(rg->counter_magic));
+        radio_model = rg->radio_model;
+        firmware_model = rg->firmware_model;
     }
 }
 
@@ -245,25 +254,30 @@ auto TYTFW::Encrypt() -> void
     ApplyXOR();
 }
 
-auto TYTFW::ApplyXOR() -> void
+auto TYTFW::SetCounterMagic(const std::vector<uint8_t> &cm) -> void
 {
-    const uint8_t *xor_model = nullptr;
-    uint32_t xor_len = 1024;
-
-    for (const auto &r : tyt::config::All)
+    counterMagic = cm;
+    cipherKey.reset();
+    auto r = tyt::config::FindByMagic(tyt::magic::PackCounterMagic(cm.data(), cm.size()));
+    if (r != nullptr)
     {
-        if (std::equal(r.counter_magic.begin(), r.counter_magic.end(), counterMagic.begin(), counterMagic.end()))
-        {
-            xor_model = r.cipher;
-            xor_len = r.cipher_len;
-            break;
-        }
+        cipherKey = r->cipher;
     }
+}
 
-    if (xor_model == nullptr)
+auto TYTFW::GetCipher() const -> keystream::CipherStream
+{
+    if (!cipherKey)
     {
         throw std::runtime_error("No cipher found");
     }
 
-    radio_tool::ApplyXOR(data, xor_model, xor_len);
+    return cipher::GetCipherInfo(*cipherKey).make(0);
+}
+
+auto TYTFW::ApplyXOR() -> void
+{
+    auto &buf = data.Mutable();
+    GetCipher().Apply(buf.data(), buf.size());
+    InvalidateCache();
 }
\ No newline at end of file
@@ -18,11 +18,14 @@
 #include <radio_tool/radio/tyt_radio.hpp>
 #include <radio_tool/fw/tyt_fw.hpp>
 #include <radio_tool/util/flash.hpp>
+#include <radio_tool/radio/flash_ledger.hpp>
 
 #include <math.h>
 #include <iomanip>
 #include <iostream>
 #include <vector>
+#include <set>
+#include <optional>
 
 using namespace radio_tool::radio;
 
@@ -40,17 +43,65 @@ auto TYTRadio::ToString() const -> const std::string
     return out.str();
 }
 
-auto TYTRadio::WriteFirmware(const std::string &file) const -> void
+auto TYTRadio::WriteFirmware(const std::string &file, const std::optional<std::string> &delta_id) const -> void
 {
     constexpr auto TransferSize = 1024u;
 
     auto fw = fw::TYTFW();
     fw.Read(file);
 
+    auto image = fw.GetImage();
+    auto next = image.GetExtents();
+
+    //compare against the last image flashed to this radio, anything unknown is a full flash
+    std::optional<FlashLedger> ledger;
+    std::optional<std::set<uint16_t>> changed;
+    std::optional<fw::TYTFW> installed;
+    if (delta_id)
+    {
+        ledger.emplace(*delta_id);
+        try
+        {
+            if (auto prev = ledger->GetInstalled())
+            {
+                installed.emplace();
+                installed->Read(*prev);
+
+                changed = flash::FlashUtil::ChangedSectors(flash::STM32F40X, installed->GetImage().GetExtents(), next);
+                std::cerr << "Delta flash: " << std::dec << changed->size() << " sectors changed" << std::endl;
+            }
+            else
+            {
+                std::cerr << "No installed image recorded, writing all sectors" << std::endl;
+            }
+        }
+        catch (const std::exception &ex)
+        {
+            std::cerr << "Installed image unusable (" << ex.what() << "), writing all sectors" << std::endl;
+            changed.reset();
+        }
+    }
+    auto write_sector = [&changed](const flash::FlashSector &sector) {
+        return !changed || changed->count(sector.index) > 0;
+    };
+
+    //the flash content is unknown until the write finishes
+    if (ledger)
+    {
+        ledger->Invalidate();
+    }
+
     dfu.SendTYTCommand(dfu::TYTCommand::FirmwareUpgrade);
-    for (auto &r : fw.GetDataSegments())
+    std::set<uint16_t> erased;
+    for (const auto &r : next)
     {
-        flash::FlashUtil::AlignedContiguousMemoryOp(flash::STM32F40X, r.address, r.address + r.size, [this](const uint32_t &addr, const uint32_t &size, const flash::FlashSector &sector) {
+        auto r_end = r.first + static_cast<uint32_t>(r.second.size());
+        flash::FlashUtil::AlignedContiguousMemoryOp(flash::STM32F40X, r.first, r_end, [this, &erased, &write_sector](const uint32_t &addr, const uint32_t &size, const flash::FlashSector &sector) {
+            if (!write_sector(sector) || !erased.insert(sector.index).second)
+            {
+                return;
+            }
+
             std::cerr << "Erasing: 0x" << std::setw(8) << std::setfill('0') << std::hex << addr
                       << " [Size=0x" << std::hex << size << "]" << std::endl
                       << "-- " << sector.ToString() << std::endl;
@@ -58,9 +109,12 @@ auto TYTRadio::WriteFirmware(const std::string &file) const -> void
             dfu.Erase(addr);
         });
 
-        auto b_offset = 0u;
-        flash::FlashUtil::AlignedContiguousMemoryOp(flash::STM32F40X, r.address, r.address + r.size, [this, &fw, &r, &TransferSize, &b_offset](const uint32_t &addr, const uint32_t &size, const flash::FlashSector &sector) {
-            const auto& binary_data = r.data;
+        flash::FlashUtil::AlignedContiguousMemoryOp(flash::STM32F40X, r.first, r_end, [this, &image, &TransferSize, &write_sector](const uint32_t &addr, const uint32_t &size, const flash::FlashSector &sector) {
+            if (!write_sector(sector))
+            {
+                return;
+            }
+
             const auto blocks = (int)std::ceil(size / (double)TransferSize);
 
             std::cerr << "Writing: 0x" << std::setw(8) << std::setfill('0') << std::hex << addr
@@ -68,11 +122,9 @@ auto TYTRadio::WriteFirmware(const std::string &file) const -> void
             dfu.SetAddress(addr);
             for(auto wValue = 0; wValue < blocks; wValue++) 
             {
-                auto block_offset = b_offset + (TransferSize * wValue);
-                auto to_write = std::vector<uint8_t>(
-                    binary_data.begin() + block_offset, 
-                    binary_data.begin() + block_offset + std::min(TransferSize, r.size - block_offset)
-                );
+                auto block_offset = TransferSize * wValue;
+                auto block = image.Read(addr + block_offset, std::min(TransferSize, size - block_offset));
+                auto to_write = std::vector<uint8_t>(block.begin(), block.end());
 
                 /*std::cerr
                     << "-- wValue=0x" << std::setw(2) << std::setfill('0') << std::hex << (2 + wValue)
@@ -80,7 +132,11 @@ auto TYTRadio::WriteFirmware(const std::string &file) const -> void
                     << std::endl;*/
                 dfu.Download(to_write, 2 + wValue);
             }
-            b_offset += size;
         });
     }
-}
\ No newline at end of file
+
+    if (ledger)
+    {
+        ledger->Store(file);
+    }
+}
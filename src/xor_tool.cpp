@@ -0,0 +1,218 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <radio_tool/fw/xor_tool.hpp>
+#include <radio_tool/util/flash.hpp>
+#include <radio_tool/util/thread_pool.hpp>
+
+#include <array>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace radio_tool::fw;
+
+/**
+ * STM32F40X has 16 core vectors + 82 interrupts
+ */
+constexpr auto VectorTableEntries = 16 + 82;
+constexpr auto VectorTableSize = VectorTableEntries * sizeof(uint32_t);
+
+/**
+ * Key columns handled by each task when voting
+ */
+constexpr auto ColumnBlock = 64u;
+
+auto XORTool::VoteColumns(const ByteView &data, const uint32_t &key_len) -> std::vector<uint8_t>
+{
+    std::vector<uint8_t> ret(key_len);
+    const auto n = data.size();
+    const auto *d = data.data();
+
+    //each task owns a block of columns so no histogram is shared between threads
+    auto blocks = (key_len + ColumnBlock - 1) / ColumnBlock;
+    radio_tool::thread::ThreadPool::Shared().ParallelFor(blocks, [&](const size_t &blk) {
+        auto c0 = blk * ColumnBlock;
+        auto c1 = std::min<size_t>(c0 + ColumnBlock, key_len);
+        std::vector<std::array<uint32_t, 256>> hist(c1 - c0);
+        for (auto &h : hist)
+        {
+            h.fill(0);
+        }
+
+        for (size_t period = 0; period + key_len + c0 < n; period += key_len)
+        {
+            //only positions with a byte one key period later
+            auto end = std::min<size_t>(period + c1, n - key_len);
+            auto i = period + c0;
+
+            //compare 8 bytes at a time, whole words of padding are the common case
+            for (; i + sizeof(uint64_t) <= end; i += sizeof(uint64_t))
+            {
+                uint64_t a, b;
+                memcpy(&a, d + i, sizeof(a));
+                memcpy(&b, d + i + key_len, sizeof(b));
+                auto x = a ^ b;
+                for (auto j = 0u; j < sizeof(uint64_t); j++)
+                {
+                    if (((x >> (j * 8)) & 0xff) == 0)
+                    {
+                        hist[i + j - period - c0][d[i + j]]++;
+                    }
+                }
+            }
+            for (; i < end; i++)
+            {
+                if (d[i] == d[i + key_len])
+                {
+                    hist[i - period - c0][d[i]]++;
+                }
+            }
+        }
+
+        for (auto c = c0; c < c1; c++)
+        {
+            auto &h = hist[c - c0];
+            auto best = std::max_element(h.begin(), h.end());
+            if (*best == 0)
+            {
+                //no repeating bytes, fall back to the most common byte of the column
+                for (auto i = c; i < n; i += key_len)
+                {
+                    h[d[i]]++;
+                }
+                best = std::max_element(h.begin(), h.end());
+            }
+            ret[c] = static_cast<uint8_t>(std::distance(h.begin(), best));
+        }
+    });
+
+    return ret;
+}
+
+auto XORTool::MakeXOR(const std::vector<uint8_t> &data, const uint32_t &key_len, const uint8_t &fill) -> std::vector<uint8_t>
+{
+    if (key_len == 0)
+    {
+        throw std::invalid_argument("Key length cannot be 0");
+    }
+
+    auto key = VoteColumns(data, key_len);
+    for (auto &k : key)
+    {
+        k ^= fill;
+    }
+    return key;
+}
+
+auto XORTool::MakeXOR(const FirmwareSupport &fw, const uint32_t &key_len) -> std::vector<uint8_t>
+{
+    if (key_len == 0)
+    {
+        throw std::invalid_argument("Key length cannot be 0");
+    }
+
+    auto columns = VoteColumns(fw.GetData(), key_len);
+
+    //padding is normally erased flash (0xFF) but some images are zero filled
+    std::vector<uint8_t> best;
+    auto best_score = -1.0;
+    for (const uint8_t fill : {0xff, 0x00})
+    {
+        auto key = columns;
+        for (auto &k : key)
+        {
+            k ^= fill;
+        }
+
+        auto score = ScoreSegments(fw, key);
+        if (score > best_score)
+        {
+            best_score = score;
+            best = std::move(key);
+        }
+    }
+    return best;
+}
+
+auto XORTool::ScoreSegments(const FirmwareSupport &fw, const std::vector<uint8_t> &key) -> double
+{
+    auto score = 0.0;
+    auto r_offset = 0u;
+    for (const auto &s : fw.GetDataSegments())
+    {
+        if (flash::FlashUtil::GetSector(flash::STM32F40X, s.address) && s.size >= VectorTableSize)
+        {
+            std::vector<uint8_t> vt(s.data.begin(), s.data.begin() + VectorTableSize);
+            keystream::Apply(vt.data(), vt.size(), key.data(), key.size(), r_offset);
+            score += ScoreVectorTable(vt.data(), vt.size());
+        }
+        r_offset += s.size;
+    }
+    return score;
+}
+
+auto XORTool::Verify(const uint32_t &address, const ByteView &data, const std::vector<uint8_t> &key, const uint32_t &key_offset) -> bool
+{
+    if (!flash::FlashUtil::GetSector(flash::STM32F40X, address) || data.size() < VectorTableSize || key.empty())
+    {
+        return false;
+    }
+
+    std::vector<uint8_t> vt(data.begin(), data.begin() + VectorTableSize);
+    keystream::Apply(vt.data(), vt.size(), key.data(), key.size(), key_offset);
+    return ScoreVectorTable(vt.data(), vt.size()) >= 0.9;
+}
+
+auto XORTool::ScoreVectorTable(const uint8_t *data, const size_t &len) -> double
+{
+    auto entries = std::min<size_t>(len / sizeof(uint32_t), VectorTableEntries);
+    if (entries < 2)
+    {
+        return 0.0;
+    }
+
+    auto word = [data](const size_t &idx) {
+        uint32_t v;
+        memcpy(&v, data + (idx * sizeof(uint32_t)), sizeof(v));
+        return v;
+    };
+    auto is_code = [](const uint32_t &addr) {
+        return (addr & 1) == 1 && flash::FlashUtil::GetSector(flash::STM32F40X, addr & ~1u).has_value();
+    };
+
+    //initial stack pointer must be word aligned inside SRAM or CCM RAM
+    auto sp = word(0);
+    auto sp_ok = (sp & 3) == 0 && ((sp > 0x20000000 && sp <= 0x20040000) || (sp > 0x10000000 && sp <= 0x10010000));
+
+    //reset handler must be thumb code in flash
+    if (!sp_ok || !is_code(word(1)))
+    {
+        return 0.0;
+    }
+
+    auto valid = 2u;
+    for (auto x = 2u; x < entries; x++)
+    {
+        auto v = word(x);
+        if (v == 0 || is_code(v))
+        {
+            valid++;
+        }
+    }
+    return valid / (double)entries;
+}
@@ -0,0 +1,89 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <radio_tool/util.hpp>
+#include <radio_tool/util/digest.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <functional>
+
+using namespace radio_tool;
+
+/**
+ * Time the best of a few runs of a checksum over the buffer
+ */
+static auto Bench(const std::string &name, const std::vector<uint8_t> &data, const std::function<uint64_t()> &fn) -> void
+{
+    constexpr auto runs = 5;
+    auto best = std::chrono::duration<double, std::milli>::max();
+    volatile uint64_t res = 0;
+    for (auto x = 0; x < runs; x++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        res = fn();
+        auto t = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start);
+        best = std::min(best, t);
+    }
+
+    std::cout << std::left << std::setw(20) << name
+              << std::right << std::fixed << std::setprecision(3) << std::setw(10) << best.count() << " ms "
+              << std::setprecision(2) << std::setw(8) << (data.size() / (best.count() / 1000.0) / 1e9) << " GB/s"
+              << " (0x" << std::hex << res << std::dec << ")" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    auto size = argc > 1 ? std::stoul(argv[1]) : 0x1000000ul;
+    std::vector<uint8_t> data(size);
+    for (auto x = 0u; x < data.size(); x++)
+    {
+        data[x] = (uint8_t)((x * 131) ^ (x >> 7));
+    }
+
+    std::cout << "Checksum kernels: " << checksum::GetKernelName() << ", " << (size / 1024) << " KiB" << std::endl;
+
+    Bench("sum (bytes)", data, [&]() {
+        uint64_t sum = 0;
+        for (const auto &b : data)
+        {
+            sum += b;
+        }
+        return sum;
+    });
+    Bench("sum", data, [&]() { return checksum::Sum(data.data(), data.size()); });
+
+    Bench("fletcher16 (bytes)", data, [&]() {
+        uint32_t c0 = 0, c1 = 0;
+        for (const auto &b : data)
+        {
+            c0 = (c0 + b) % 255;
+            c1 = (c1 + c0) % 255;
+        }
+        return (uint64_t)(c1 << 8 | c0);
+    });
+    Bench("fletcher16", data, [&]() { return checksum::Fletcher16(data.data(), data.size()); });
+    Bench("internet", data, [&]() { return checksum::Internet(data.data(), data.size()); });
+    Bench("bsd", data, [&]() { return checksum::BSD(data.data(), data.size()); });
+    Bench("cs", data, [&]() { return CSChecksum(data.data(), data.size()); });
+
+    std::cout << "Digest kernels: " << digest::GetKernelName() << std::endl;
+    Bench("crc32", data, [&]() { return digest::CRC32(data.data(), data.size()); });
+    Bench("sha256", data, [&]() { return (uint64_t)digest::SHA256::Hash(data.data(), data.size())[0]; });
+}
@@ -3,6 +3,7 @@
 
 #include <radio_tool/util.hpp>
 #include <radio_tool/fw/fw_factory.hpp>
+#include <radio_tool/fw/fw_wrap.hpp>
 
 int main(int argc, char **argv)
 {
@@ -27,6 +28,47 @@ int main(int argc, char **argv)
         exit(1);
     }
 
+    //header only parse must agree with the full read
+    auto info = radio_tool::fw::FirmwareFactory::GetFirmwareFileInfo(file);
+    if (info->GetRadioModel() != h->GetRadioModel() || info->GetMemoryRanges() != h->GetMemoryRanges() || !info->GetData().empty())
+    {
+        std::cerr << "Header only parse incorrect" << std::endl;
+        exit(1);
+    }
+
+    //decrypted view must match decrypting a copy of the whole image
+    {
+        auto view = h->GetDecryptedView();
+        auto plain = radio_tool::fw::FirmwareFactory::GetFirmwareFileHandler(file);
+        plain->Read(file);
+        plain->Decrypt();
+        const auto &full = plain->GetData();
+
+        std::vector<uint8_t> buf(0x2345);
+        for (const auto &off : {uint64_t(0), uint64_t(0xff1), uint64_t(0x10003), uint64_t(full.size() - 0x11)})
+        {
+            if (off >= full.size())
+                continue;
+            auto n = std::min<uint64_t>(buf.size(), full.size() - off);
+            view.Read(off, buf.data(), n);
+            if (!std::equal(buf.begin(), buf.begin() + n, full.begin() + off))
+            {
+                std::cerr << "Decrypted view incorrect at 0x" << std::hex << off << std::endl;
+                exit(1);
+            }
+        }
+        for (const auto &seg : plain->GetDataSegments())
+        {
+            uint8_t vt[8];
+            view.ReadAddress(seg.address, vt, sizeof(vt));
+            if (!std::equal(vt, vt + sizeof(vt), seg.data.begin()))
+            {
+                std::cerr << "Decrypted view address read incorrect" << std::endl;
+                exit(1);
+            }
+        }
+    }
+
     //Unwrap and rebuild firmware
     auto write_test_name = "write_test_";
     auto write_test = "write_test_wrapped.bin";
@@ -72,7 +114,7 @@ int main(int argc, char **argv)
             fw_in.read((char*)fw_data.data(), size);
             fw_in.close();
 
-            fw_new->AppendSegment(seg.first, fw_data);
+            fw_new->AppendSegment(seg.first, std::move(fw_data));
         } 
         else 
         {
@@ -81,6 +123,78 @@ int main(int argc, char **argv)
         }
     }
     fw_new->Write(write_test);
+
+    //streamed wrap must match encrypting and writing the loaded segments
+    std::vector<std::pair<uint32_t, std::string>> seg_files;
+    for(const auto& seg : segs)
+    {
+        std::stringstream ss_name;
+        ss_name << write_test_name << "_0x" << std::setw(8) << std::setfill('0') << std::hex << seg.first;
+        seg_files.push_back({seg.first, ss_name.str()});
+    }
+    auto fw_stream = radio_tool::fw::FirmwareFactory::GetFirmwareModelHandler(h->GetRadioModel());
+    fw_stream->SetRadioModel(h->GetRadioModel());
+    fw_stream->WriteSegments("write_test_streamed.bin", seg_files);
+    {
+        //multi target wrap, each output must match a single target wrap with its own counter magic and cipher
+        std::vector<std::string> radios = {h->GetRadioModel()};
+        if(radio_tool::fw::TYTFW::SupportsRadioModel(h->GetRadioModel()))
+        {
+            for(const auto& r : {"MD2017", "UV3X0 GPS"})
+            {
+                if(r != h->GetRadioModel()) radios.push_back(r);
+            }
+        }
+
+        std::vector<radio_tool::fw::WrapTarget> targets;
+        for(auto x = 0u; x < radios.size(); x++)
+        {
+            targets.push_back({radios[x], "write_test_multi_" + std::to_string(x) + ".bin"});
+        }
+        std::vector<std::pair<uint32_t, radio_tool::ByteView>> plain;
+        for(const auto& seg : fw_new->GetDataSegments())
+        {
+            plain.push_back({seg.address, seg.data});
+        }
+        radio_tool::fw::FirmwareWrap::Run(targets, plain);
+
+        std::vector<std::vector<char>> outputs;
+        for(const auto& t : targets)
+        {
+            auto single = radio_tool::fw::FirmwareFactory::GetFirmwareModelHandler(t.radio);
+            single->SetRadioModel(t.radio);
+            single->WriteSegments("write_test_single.bin", seg_files);
+
+            std::ifstream fs(t.file, std::ios_base::binary);
+            std::ifstream fe("write_test_single.bin", std::ios_base::binary);
+            outputs.emplace_back(std::istreambuf_iterator<char>(fs), std::istreambuf_iterator<char>());
+            if(outputs.back() != std::vector<char>(std::istreambuf_iterator<char>(fe), std::istreambuf_iterator<char>()))
+            {
+                std::cerr << "Multi target wrap does not match for " << t.radio << std::endl;
+                exit(1);
+            }
+        }
+        for(auto x = 1u; x < outputs.size(); x++)
+        {
+            if(outputs[x] == outputs[0])
+            {
+                std::cerr << "Multi target wrap made the same file for " << radios[0] << " and " << radios[x] << std::endl;
+                exit(1);
+            }
+        }
+    }
+    fw_new->Encrypt();
+    fw_new->Write("write_test_encrypted.bin");
+    {
+        std::ifstream fs("write_test_streamed.bin", std::ios_base::binary);
+        std::ifstream fe("write_test_encrypted.bin", std::ios_base::binary);
+        if(!std::equal(std::istreambuf_iterator<char>(fs), std::istreambuf_iterator<char>(),
+                       std::istreambuf_iterator<char>(fe), std::istreambuf_iterator<char>()))
+        {
+            std::cerr << "Streamed wrap does not match" << std::endl;
+            exit(1);
+        }
+    }
     std::ifstream fa(file, std::ios_base::binary);
     std::ifstream fb(write_test, std::ios_base::binary);
 
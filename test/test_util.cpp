@@ -1,19 +1,733 @@
 #include <radio_tool/util.hpp>
+#include <radio_tool/util/digest.hpp>
+#include <radio_tool/util/flash.hpp>
+#include <radio_tool/radio/flash_ledger.hpp>
+#include <radio_tool/fw/cipher/md380.hpp>
+#include <radio_tool/fw/fw_store.hpp>
+#include <radio_tool/fw/tyt_fw.hpp>
+#include <radio_tool/fw/cs_fw.hpp>
+#include <radio_tool/fw/fw_image.hpp>
+#include <radio_tool/fw/fw_batch.hpp>
+#include <radio_tool/fw/fw_wrap.hpp>
+#include <radio_tool/fw/fw_factory.hpp>
+#include <radio_tool/fw/fw_catalog.hpp>
+#include <radio_tool/fw/xor_tool.hpp>
+#include <radio_tool/util/elf.hpp>
+
+#include <fstream>
+#include <filesystem>
 
 #include <assert.h>
 
 using namespace radio_tool;
+
+static auto TestXOR() -> void
+{
+    std::vector<uint8_t> plain(5000);
+    for (auto x = 0u; x < plain.size(); x++)
+    {
+        plain[x] = (uint8_t)(x * 7 + 3);
+    }
+
+    for (const auto &len : {0, 1, 63, 64, 200, 1023, 1024, 1025, 4999})
+    {
+        for (const auto &offset : {0, 1, 17, 1023, 1500})
+        {
+            std::vector<uint8_t> test(plain.begin(), plain.begin() + len);
+            ApplyXOR(test, fw::cipher::md380, fw::cipher::md380_length, offset);
+            for (auto x = 0; x < len; x++)
+            {
+                assert(test[x] == (plain[x] ^ fw::cipher::md380[(x + offset) % fw::cipher::md380_length]));
+            }
+        }
+    }
+
+    //chunked stream must match a single pass
+    std::vector<uint8_t> whole(plain), chunked(plain);
+    ApplyXOR(whole, fw::cipher::md380, fw::cipher::md380_length);
+    auto stream = keystream::CipherStream(fw::cipher::md380, fw::cipher::md380_length);
+    for (auto x = 0u; x < chunked.size(); x += 333)
+    {
+        stream.Apply(chunked.data() + x, std::min<size_t>(333, chunked.size() - x));
+    }
+    assert(whole == chunked);
+    assert(stream.GetOffset() == plain.size());
+
+    //large buffers are split across threads, must match single threaded
+    std::vector<uint8_t> big(keystream::ParallelThreshold * 3 + 123);
+    for (auto x = 0u; x < big.size(); x++)
+    {
+        big[x] = (uint8_t)(x >> 3);
+    }
+    auto big_single(big), big_parallel(big);
+    keystream::SetThreadLimit(1);
+    auto sum_single = keystream::Sum(big.data(), big.size(), fw::cipher::md380, fw::cipher::md380_length, 5);
+    ApplyXOR(big_single, fw::cipher::md380, fw::cipher::md380_length, 5);
+    keystream::SetThreadLimit(4);
+    auto sum_parallel = keystream::Sum(big.data(), big.size(), fw::cipher::md380, fw::cipher::md380_length, 5);
+    ApplyXOR(big_parallel, fw::cipher::md380, fw::cipher::md380_length, 5);
+    keystream::SetThreadLimit(0);
+    assert(big_single == big_parallel);
+    assert(sum_single == sum_parallel);
+}
+
+/**
+ * Vector kernels must match the byte at a time definitions at every length/alignment
+ */
+static auto TestChecksum() -> void
+{
+    std::vector<uint8_t> data(0x5000);
+    for (auto x = 0u; x < data.size(); x++)
+    {
+        data[x] = (uint8_t)((x * 131) ^ (x >> 7));
+    }
+    std::fill(data.begin() + 0x3000, data.begin() + 0x4800, 0xff);
+
+    for (const auto &len : {0u, 1u, 2u, 15u, 31u, 33u, 257u, 4095u, 4096u, 4097u, 5802u, 0x4fffu})
+    {
+        for (const auto &align : {0u, 1u, 3u})
+        {
+            auto d = data.data() + align;
+
+            uint64_t sum = 0;
+            uint32_t c0 = 0, c1 = 0;
+            uint64_t words = 0;
+            for (auto x = 0u; x < len; x++)
+            {
+                sum += d[x];
+                c0 = (c0 + d[x]) % 255;
+                c1 = (c1 + c0) % 255;
+                words += x & 1 ? d[x] : d[x] << 8;
+            }
+            while (words >> 16)
+            {
+                words = (words & 0xffff) + (words >> 16);
+            }
+
+            assert(checksum::Sum(d, len) == sum);
+            assert(checksum::Fletcher16(d, len) == (c1 << 8 | c0));
+            assert(checksum::Internet(d, len) == (uint16_t)~words);
+            assert(CSChecksum(d, len) == CSChecksum((uint16_t)sum));
+        }
+    }
+
+    //states fed in chunks, or combined from partial states, must match one shot
+    for (const auto &split : {0u, 1u, 7u, 4096u, 0x2345u})
+    {
+        auto d = data.data();
+        auto len = data.size();
+
+        checksum::CSState cs_a, cs_b;
+        checksum::Fletcher16State f_a, f_b;
+        checksum::InternetState i_a, i_b;
+        checksum::BSDState bsd;
+
+        cs_a.Update(d, split);
+        cs_b.Update(d + split, len - split);
+        cs_a.Combine(cs_b);
+        assert(cs_a.Finalize() == CSChecksum(d, len));
+        assert(cs_a.GetLength() == len);
+
+        f_a.Update(d, split);
+        f_b.Update(d + split, len - split);
+        f_a.Combine(f_b);
+        assert(f_a.Finalize() == checksum::Fletcher16(d, len));
+
+        i_a.Update(d, split);
+        i_b.Update(d + split, len - split);
+        i_a.Combine(i_b);
+        assert(i_a.Finalize() == checksum::Internet(d, len));
+
+        bsd.Update(d, split);
+        bsd.Update(d + split, len - split);
+        assert(bsd.Finalize() == checksum::BSD(d, len));
+    }
+
+    //RFC 1071 example
+    const uint8_t rfc1071[] = {0x00, 0x01, 0xf2, 0x03, 0xf4, 0xf5, 0xf6, 0xf7};
+    assert(checksum::Internet(rfc1071, sizeof(rfc1071)) == (uint16_t)~0xddf2);
+}
+
+static auto TestDigest() -> void
+{
+    const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    assert(digest::CRC32(check, sizeof(check)) == 0xcbf43926);
+
+    const uint8_t abc[] = {'a', 'b', 'c'};
+    assert(digest::ToHex(digest::SHA256::Hash(abc, sizeof(abc))) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+    //running digests over chunks must match one shot
+    std::vector<uint8_t> data(1000);
+    for (auto x = 0u; x < data.size(); x++)
+    {
+        data[x] = (uint8_t)(x * 13 + (x >> 3));
+    }
+    auto crc = digest::CRC32(data.data(), 333);
+    crc = digest::CRC32(data.data() + 333, data.size() - 333, crc);
+    assert(crc == digest::CRC32(data.data(), data.size()));
+
+    digest::SHA256 h;
+    h.Update(data.data(), 63);
+    h.Update(data.data() + 63, 130);
+    h.Update(data.data() + 193, data.size() - 193);
+    assert(h.Finalize() == digest::SHA256::Hash(data.data(), data.size()));
+}
+
+static auto TestFlashDelta() -> void
+{
+    //segment 0x0800c000 spans sectors 3 and 4, segment 0x08020000 is in sector 5
+    std::vector<uint8_t> a(0x8000, 0x11), b(0x1000, 0x22);
+    std::vector<std::pair<uint32_t, ByteView>> installed = {{0x0800c000, ByteView(a)}, {0x08020000, ByteView(b)}};
+
+    assert(flash::FlashUtil::ChangedSectors(flash::STM32F40X, installed, installed).empty());
+
+    //one byte in sector 4
+    auto a2 = a;
+    a2[0x5000] = 0;
+    std::vector<std::pair<uint32_t, ByteView>> next = {{0x0800c000, ByteView(a2)}, {0x08020000, ByteView(b)}};
+    assert(flash::FlashUtil::ChangedSectors(flash::STM32F40X, installed, next) == std::set<uint16_t>({4}));
+
+    //shorter segment changes the sector it ends in, new sectors are always written
+    next = {{0x0800c000, ByteView(a.data(), 0x6000)}, {0x08020000, ByteView(b)}, {0x08040000, ByteView(b)}};
+    assert(flash::FlashUtil::ChangedSectors(flash::STM32F40X, installed, next) == std::set<uint16_t>({4, 6}));
+
+    //ledger ids are file names, nothing which could leave the ledger directory
+    for (const auto &id : {"", "../x", "a/b", "a.b"})
+    {
+        auto threw = false;
+        try { radio::FlashLedger ledger(id, "ledger_test"); } catch (const std::invalid_argument &) { threw = true; }
+        assert(threw);
+    }
+    radio::FlashLedger ledger("0123ABCD-x_y", "ledger_test");
+    assert(!ledger.GetInstalled());
+}
+
+static auto TestChunking() -> void
+{
+    std::vector<uint8_t> data(0x40000);
+    uint32_t x = 1;
+    for (auto &b : data)
+    {
+        x = x * 1103515245 + 12345;
+        b = (uint8_t)(x >> 16);
+    }
+
+    auto a = fw::FirmwareStore::Chunk(ByteView(data));
+    size_t total = 0;
+    for (const auto &n : a)
+    {
+        assert(n <= fw::FirmwareStore::MaxChunkSize);
+        total += n;
+    }
+    assert(total == data.size());
+
+    //inserting bytes at the start only moves the first boundary, the rest line up again
+    auto shifted = data;
+    shifted.insert(shifted.begin(), 100, 0x55);
+    auto b = fw::FirmwareStore::Chunk(ByteView(shifted));
+    assert(a.size() > 4 && b.size() == a.size());
+    assert(b[0] == a[0] + 100 && std::equal(a.begin() + 1, a.end(), b.begin() + 1));
+}
+
+static auto TestRadioLookup() -> void
+{
+    //lookups resolve at compile time
+    static_assert(fw::tyt::config::FindByMagic(fw::tyt::magic::DM1701)->cipher == fw::cipher::CipherKey::DM1701);
+    static_assert(fw::tyt::config::FindByModel("UV3X0")->counter_magic == fw::tyt::magic::UV3X0);
+    static_assert(fw::tyt::config::FindByModel("UV3X") == nullptr);
+    static_assert(fw::tyt::config::FindByMagic(0x0d02) == nullptr);
+
+    //tables agree with a linear scan of the configs, first entry wins
+    for (const auto &r : fw::tyt::config::All)
+    {
+        auto m = fw::tyt::magic::PackCounterMagic(r.counter_magic.data(), r.counter_magic.size());
+        auto by_magic = std::find_if(fw::tyt::config::All.begin(), fw::tyt::config::All.end(), [&](const auto &o) { return o.counter_magic == r.counter_magic; });
+        auto by_model = std::find_if(fw::tyt::config::All.begin(), fw::tyt::config::All.end(), [&](const auto &o) { return o.radio_model == r.radio_model; });
+        assert(fw::tyt::config::FindByMagic(m)->radio_model == by_magic->radio_model);
+        assert(fw::TYTFW::GetCounterMagic(r.radio_model) == by_model->counter_magic);
+    }
+}
+
+static auto TestFirmwareImage() -> void
+{
+    std::vector<uint8_t> a(0x100, 0xaa), b(0x80, 0xbb);
+    fw::FirmwareImage img;
+    img.Add(0x1000, ByteView(b));
+    img.Add(0x0800, ByteView(a));
+    assert(img.GetStart() == 0x0800 && img.GetEnd() == 0x1080 && img.GetSize() == 0x180);
+    assert(img.GetExtents().front().first == 0x0800);
+    assert(img.Overlaps(0x08ff, 1) && !img.Overlaps(0x0900, 0x700) && img.Overlaps(0x0900, 0x701));
+    assert(img.Contains(0x1000, 0x80) && !img.Contains(0x1000, 0x81));
+    assert(img.Read(0x1010, 4).data() == b.data() + 0x10);
+
+    auto threw = false;
+    try { img.Add(0x0900 - 1, ByteView(b)); } catch (const std::runtime_error &) { threw = true; }
+    assert(threw);
+
+    //writes inside an extent copy it, the caller's data is unchanged
+    uint8_t patch[] = {1, 2};
+    img.Write(0x0810, ByteView(patch, sizeof(patch)));
+    assert(img.Read(0x0810, 2)[1] == 2 && a[0x11] == 0xaa);
+
+    //writes across a gap merge everything they touch
+    img.Write(0x08f0, ByteView(patch, sizeof(patch)));
+    std::vector<uint8_t> gap(0x700, 0x11);
+    img.Write(0x0900, ByteView(gap));
+    assert(img.GetExtents().size() == 1 && img.GetSize() == 0x880);
+    assert(img.Read(0x08f1, 1)[0] == 2 && img.Read(0x0fff, 2)[0] == 0x11 && img.Read(0x0fff, 2)[1] == 0xbb);
+
+    //flat export fills gaps
+    fw::FirmwareImage sparse;
+    sparse.Add(0x10, ByteView(patch, sizeof(patch)));
+    sparse.Add(0x12, ByteView(patch, sizeof(patch)));
+    sparse.Add(0x20, ByteView(patch, sizeof(patch)));
+    auto flat = sparse.Flatten();
+    assert(flat.size() == 0x12 && flat[3] == 2 && flat[4] == 0xff && flat[0x11] == 2);
+    sparse.Merge();
+    assert(sparse.GetExtents().size() == 2 && sparse.Read(0x10, 4)[2] == 1);
+}
+
+/**
+ * Write a small TYT firmware file with pseudo random segments
+ */
+static auto MakeTestFirmware(const std::string &file, const std::string &radio, const uint32_t &seed) -> void
+{
+    std::vector<uint8_t> a(0x3000), b(0x1234);
+    auto x = seed;
+    for (auto *seg : {&a, &b})
+    {
+        for (auto &v : *seg)
+        {
+            x = x * 1103515245 + 12345;
+            v = (uint8_t)(x >> 16);
+        }
+    }
+
+    fw::TYTFW f;
+    f.SetRadioModel(radio);
+    f.SetSegments({{0x0800c000, ByteView(a)}, {0x08020000, ByteView(b)}});
+    f.Encrypt();
+    f.Write(file);
+}
+
+static auto TestBatch() -> void
+{
+    namespace fs = std::filesystem;
+    fs::remove_all("batch_test");
+    fs::create_directories("batch_test/a");
+    fs::create_directories("batch_test/b");
+    MakeTestFirmware("batch_test/a/fw.bin", "MD380", 1);
+    MakeTestFirmware("batch_test/b/fw.bin", "UV3X0", 2);
+    MakeTestFirmware("batch_test/b/other.bin", "DM1701", 3);
+    std::ofstream("batch_test/b/notes.txt") << "not firmware";
+
+    assert(fw::FirmwareBatch::GlobMatch("*.bin", "fw.bin") && fw::FirmwareBatch::GlobMatch("f?.b*", "fw.bin"));
+    assert(!fw::FirmwareBatch::GlobMatch("*.bin", "fw.bin.txt") && !fw::FirmwareBatch::GlobMatch("?w", "fw.bin"));
+    assert(fw::FirmwareBatch::GlobMatch("*", "") && fw::FirmwareBatch::GlobMatch("a*b*c", "aXbYbc"));
+
+    //directories are recursive and sorted, globs match file names, unmatched inputs are kept
+    auto files = fw::FirmwareBatch::ExpandInputs({"batch_test", "batch_test/b/*.bin", "batch_test/missing*"});
+    std::vector<std::string> expect = {
+        (fs::path("batch_test") / "a" / "fw.bin").string(), (fs::path("batch_test") / "b" / "fw.bin").string(),
+        (fs::path("batch_test") / "b" / "notes.txt").string(), (fs::path("batch_test") / "b" / "other.bin").string(),
+        (fs::path("batch_test/b") / "fw.bin").string(), (fs::path("batch_test/b") / "other.bin").string(),
+        "batch_test/missing*"};
+    assert(files == expect);
+
+    //same file names get distinct outputs, the same file twice collides
+    auto prefixes = fw::FirmwareBatch::GetOutputPrefixes({"a/fw.bin", "b/fw.bin", "c/x.bin", "a/fw.bin"}, "out");
+    assert(prefixes[0] != prefixes[1] && !prefixes[0].empty() && !prefixes[1].empty());
+    assert(prefixes[2] == (fs::path("out") / "x.bin").string() && prefixes[3].empty());
+
+    //records are emitted in input order even with many jobs
+    fw::BatchOptions opt;
+    opt.op = fw::BatchOp::Unwrap;
+    opt.out_dir = "batch_test/out";
+    opt.jobs = 4;
+    files = {"batch_test/a/fw.bin", "batch_test/b/fw.bin", "batch_test/b/notes.txt", "batch_test/b/other.bin", "batch_test/a/fw.bin"};
+    std::vector<fw::BatchRecord> records;
+    auto failed = fw::FirmwareBatch::Run(files, opt, [&records](const fw::BatchRecord &r) { records.push_back(r); });
+    assert(failed == 2 && records.size() == files.size());
+    for (auto x = 0u; x < files.size(); x++)
+    {
+        assert(records[x].file == files[x]);
+    }
+    assert(records[0].model == "MD380" && records[1].model == "UV3X0" && records[3].model == "DM1701");
+    assert(!records[2].error.empty() && !records[4].error.empty());
+
+    //both fw.bin files were unwrapped to their own outputs
+    assert(records[0].outputs.size() == 2 && records[1].outputs.size() == 2);
+    for (const auto &o : records[0].outputs)
+    {
+        assert(std::find(records[1].outputs.begin(), records[1].outputs.end(), o) == records[1].outputs.end());
+        assert(fs::exists(o));
+    }
+
+    fw::BatchRecord rec;
+    rec.file = "dir\\a \"b\".bin";
+    rec.model = "MD380";
+    rec.size = 0x200;
+    rec.segments = {{0x0800c000, 0x200}};
+    rec.crc32 = 0xabc;
+    assert(rec.ToJSON() == "{\"file\":\"dir\\\\a \\\"b\\\".bin\",\"model\":\"MD380\",\"size\":512,"
+                           "\"segments\":[{\"address\":\"0x0800c000\",\"size\":512}],\"crc32\":\"00000abc\",\"error\":null}");
+    rec.model.clear();
+    rec.error = "bad\n";
+    assert(rec.ToJSON().find("\"model\":null") != std::string::npos && rec.ToJSON().find("\"error\":\"bad\\n\"}") != std::string::npos);
+}
+
+static auto ReadFile(const std::string &file) -> std::vector<uint8_t>
+{
+    std::ifstream f(file, std::ios_base::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+}
+
+static auto WriteFile(const std::string &file, const std::vector<uint8_t> &data) -> void
+{
+    std::ofstream f(file, std::ios_base::binary);
+    f.write((const char *)data.data(), data.size());
+}
+
+static auto TestElf() -> void
+{
+    //ELF32 header, 4 program headers then the segment data
+    std::vector<uint8_t> elf(0x600);
+    auto put = [&elf](const size_t &at, const uint32_t &v, const size_t &len) {
+        memcpy(elf.data() + at, &v, len);
+    };
+    auto phdr = [&put](const size_t &idx, const uint32_t &type, const uint32_t &offset, const uint32_t &paddr, const uint32_t &filesz, const uint32_t &memsz) {
+        auto at = 52 + idx * 32;
+        put(at, type, 4);
+        put(at + 4, offset, 4);
+        put(at + 8, paddr + 0x10000000, 4); //vaddr differs, paddr is used
+        put(at + 12, paddr, 4);
+        put(at + 16, filesz, 4);
+        put(at + 20, memsz, 4);
+    };
+    uint8_t ident[] = {0x7f, 'E', 'L', 'F', 1, 1, 1};
+    memcpy(elf.data(), ident, sizeof(ident));
+    put(16, 2, 2);    //e_type EXEC
+    put(18, 0x28, 2); //e_machine ARM
+    put(28, 52, 4);   //e_phoff
+    put(42, 32, 2);   //e_phentsize
+    put(44, 4, 2);    //e_phnum
+    phdr(0, 1, 0x400, 0x08020000, 0x123, 0x123);
+    phdr(1, 4, 0x100, 0x08030000, 0x10, 0x10);     //PT_NOTE
+    phdr(2, 1, 0x100, 0x20000000, 0, 0x800);        //.bss
+    phdr(3, 1, 0x100, 0x0800c000, 0x300, 0x300);
+    for (auto x = 0x100u; x < elf.size(); x++)
+    {
+        elf[x] = (uint8_t)(x * 13);
+    }
+    WriteFile("elf_test.elf", elf);
+
+    assert(elf::ElfFile::IsElf(ByteView(elf)));
+    auto f = elf::ElfFile::Open("elf_test.elf");
+    const auto &segs = f.GetLoadSegments();
+    assert(segs.size() == 2);
+    assert(segs[0].address == 0x0800c000 && segs[0].data.size() == 0x300 && segs[0].data[0] == elf[0x100]);
+    assert(segs[1].address == 0x08020000 && segs[1].data.size() == 0x123 && segs[1].data[0] == elf[0x400]);
+
+    //the ELF wraps to the same file as its segments passed with -s
+    std::vector<std::pair<uint32_t, std::string>> seg_files;
+    std::vector<std::pair<uint32_t, ByteView>> seg_views;
+    for (const auto &s : segs)
+    {
+        auto name = "elf_test_" + std::to_string(s.address) + ".bin";
+        WriteFile(name, std::vector<uint8_t>(s.data.begin(), s.data.end()));
+        seg_files.push_back({s.address, name});
+        seg_views.push_back({s.address, s.data});
+    }
+    fw::TYTFW from_elf, from_files;
+    from_elf.SetRadioModel("DM1701");
+    from_elf.SetSegments(seg_views);
+    from_elf.Encrypt();
+    from_elf.Write("elf_test_wrap.bin");
+    from_files.SetRadioModel("DM1701");
+    from_files.WriteSegments("elf_test_segments.bin", seg_files);
+    assert(ReadFile("elf_test_wrap.bin") == ReadFile("elf_test_segments.bin"));
+
+    //truncated program header table, then a segment past the end of the file
+    auto bad = [](const std::vector<uint8_t> &data) {
+        WriteFile("elf_test_bad.elf", data);
+        try { elf::ElfFile::Open("elf_test_bad.elf"); } catch (const std::runtime_error &) { return true; }
+        return false;
+    };
+    auto truncated = std::vector<uint8_t>(elf.begin(), elf.begin() + 52 + 3 * 32 + 8);
+    assert(bad(truncated));
+    put(44, 100, 2);
+    assert(bad(elf));
+    put(44, 4, 2);
+    phdr(3, 1, 0x500, 0x0800c000, 0x300, 0x300);
+    assert(bad(elf));
+    phdr(3, 1, 0xffffff00, 0x0800c000, 0x300, 0x300);
+    assert(bad(elf));
+    phdr(3, 1, 0x100, 0xffffff00, 0x300, 0x300);
+    assert(bad(elf));
+}
+
+static auto TestStore() -> void
+{
+    namespace fs = std::filesystem;
+    fs::remove_all("store_test");
+    fs::create_directories("store_test");
+    MakeTestFirmware("store_test/tyt.bin", "UV3X0", 7);
+    {
+        std::vector<uint8_t> image(0x9000);
+        for (auto x = 0u; x < image.size(); x++)
+        {
+            image[x] = (uint8_t)(x * 31 + (x >> 9));
+        }
+        fw::CSFW cs;
+        cs.SetSegments({{0x10000, ByteView(image)}});
+        cs.Encrypt();
+        cs.Write("store_test/cs.bin");
+    }
+
+    //files are rebuilt bit exact
+    fw::FirmwareStore store("store_test/store");
+    for (const auto &name : {"tyt", "cs"})
+    {
+        auto file = std::string("store_test/") + name + ".bin";
+        assert(store.Add(file, name) > 0);
+        store.Extract(name, "store_test/out.bin");
+        assert(ReadFile("store_test/out.bin") == ReadFile(file));
+    }
+    assert(store.List() == std::vector<std::string>({"cs", "tyt"}));
+
+    //adding the same file again stores nothing new
+    assert(store.Add("store_test/tyt.bin", "tyt2") == 0);
+
+    //a damaged chunk fails the rebuild and leaves no output behind
+    fs::remove("store_test/out.bin");
+    for (const auto &e : fs::recursive_directory_iterator("store_test/store/chunks"))
+    {
+        if (e.is_regular_file())
+        {
+            fs::resize_file(e.path(), fs::file_size(e.path()) - 1);
+        }
+    }
+    auto threw = false;
+    try { store.Extract("tyt", "store_test/out.bin"); } catch (const std::runtime_error &) { threw = true; }
+    assert(threw && !fs::exists("store_test/out.bin") && !fs::exists("store_test/out.bin.tmp"));
+}
+
+static auto TestMultiWrap() -> void
+{
+    std::vector<uint8_t> a(0x2345), b(0x800);
+    for (auto x = 0u; x < a.size(); x++)
+    {
+        a[x] = (uint8_t)(x * 7);
+    }
+    WriteFile("multi_a.bin", a);
+    WriteFile("multi_b.bin", b);
+
+    //each target gets its own counter magic and cipher, and matches a single target wrap
+    std::vector<std::string> radios = {"MD2017", "UV3X0 GPS", "MD9600"};
+    std::vector<fw::WrapTarget> targets;
+    for (const auto &r : radios)
+    {
+        targets.push_back({r, fw::FirmwareWrap::GetOutputName("multi.bin", r)});
+    }
+    assert(targets[1].file == "multi_UV3X0_GPS.bin");
+    fw::FirmwareWrap::Run(targets, {{0x0800c000, ByteView(a)}, {0x08100000, ByteView(b)}});
+
+    std::vector<std::vector<uint8_t>> outputs;
+    for (const auto &t : targets)
+    {
+        fw::TYTFW single;
+        single.SetRadioModel(t.radio);
+        single.WriteSegments("multi_single.bin", {{0x0800c000, "multi_a.bin"}, {0x08100000, "multi_b.bin"}});
+        outputs.push_back(ReadFile(t.file));
+        assert(outputs.back() == ReadFile("multi_single.bin"));
+
+        auto h = fw::FirmwareFactory::GetFirmwareFileHandler(t.file);
+        h->Read(t.file);
+        assert(h->GetRadioModel() == t.radio);
+    }
+    assert(outputs[0] != outputs[1] && outputs[1] != outputs[2]);
+
+    assert(fw::FirmwareWrap::ExpandTargets("MD380,MD-9600,MD380") ==
+           std::vector<std::string>({"MD380", "MD2017", "MD2017 GPS", "MD9600", "UV3X0 GPS", "UV3X0"}));
+}
+
+static auto TestMalformedHeader() -> void
+{
+    //region count which wraps to 8 bytes of table when multiplied by 8
+    std::vector<uint8_t> file(0x1000, 0xff);
+    fw::TYTFirmwareHeader h = {};
+    std::copy(fw::tyt::magic::begin.begin(), fw::tyt::magic::begin.end(), h.magic);
+    h.counter_magic[0] = 0x01;
+    h.counter_magic[1] = 0x0d;
+    h.n_regions = 0x20000001;
+    memcpy(file.data(), &h, sizeof(h));
+
+    assert(!fw::TYTFW::SupportsFirmwareFile(ByteView(file), file.size()));
+    auto threw = false;
+    try { fw::TYTFW().ReadHeader(ByteView(file), file.size()); } catch (const std::runtime_error &) { threw = true; }
+    assert(threw);
+
+    //a full table is fine, one more region is not
+    h.n_regions = 16;
+    memcpy(file.data(), &h, sizeof(h));
+    assert(fw::TYTFW::SupportsFirmwareFile(ByteView(file), file.size()));
+    h.n_regions = 17;
+    memcpy(file.data(), &h, sizeof(h));
+    assert(!fw::TYTFW::SupportsFirmwareFile(ByteView(file), file.size()));
+
+    //CS image size only matches the file because of a short image header,
+    //the checksum would be read from past the end of the file
+    fw::CS800D_header cs = {};
+    cs.imagesize = 0x1000 - sizeof(cs) - sizeof(uint16_t) + 2;
+    cs.imageHeaderSize = sizeof(cs) - 2;
+    std::fill(file.begin(), file.end(), 0);
+    memcpy(file.data(), &cs, sizeof(cs));
+    assert(!fw::CSFW::SupportsFirmwareFile(ByteView(file), file.size()));
+    cs.imagesize -= 2;
+    cs.imageHeaderSize = sizeof(cs);
+    memcpy(file.data(), &cs, sizeof(cs));
+    assert(fw::CSFW::SupportsFirmwareFile(ByteView(file), file.size()));
+
+    //a header only read has ranges but no data, nothing may be read past it
+    MakeTestFirmware("header_only.bin", "MD380", 9);
+    auto full = ReadFile("header_only.bin");
+    auto prefix = std::vector<uint8_t>(full.begin(), full.begin() + fw::FirmwareFactory::SniffSize);
+    fw::TYTFW header_only;
+    header_only.ReadHeader(ByteView(prefix), full.size());
+    assert(header_only.GetMemoryRanges().size() == 2 && header_only.GetData().empty());
+
+    std::filesystem::remove("header_only_0x0800c000");
+    threw = false;
+    try { header_only.UnwrapSegments("header_only"); } catch (const std::out_of_range &) { threw = true; }
+    assert(threw && !std::filesystem::exists("header_only_0x0800c000"));
+
+    threw = false;
+    try { fw::XORTool::MakeXOR(header_only); } catch (const std::out_of_range &) { threw = true; }
+    assert(threw);
+}
+
+static auto TestCatalog() -> void
+{
+    namespace fs = std::filesystem;
+    fs::remove_all("catalog_test");
+    fs::create_directories("catalog_test/sub");
+    MakeTestFirmware("catalog_test/a.bin", "MD380", 1);
+    MakeTestFirmware("catalog_test/sub/b.bin", "UV3X0", 2);
+    std::ofstream("catalog_test/notes.txt") << "not firmware";
+
+    {
+        fw::FirmwareCatalog cat("catalog_test");
+        assert(cat.Update() == 3);
+        cat.Save();
+    }
+
+    //a damaged index line is skipped, the rest of the index is still used
+    std::ofstream("catalog_test/" + std::string(fw::FirmwareCatalog::IndexName), std::ios_base::app)
+        << "c.bin\tx\t0\tzz\t\t\t0\t\n";
+
+    //nothing changed, nothing is read again
+    {
+        fw::FirmwareCatalog cat("catalog_test");
+        assert(cat.Update() == 0);
+        assert(cat.GetEntries().size() == 3);
+    }
+
+    //only the changed file is read again, the mtime is moved explicitly as the
+    //rewrite keeps the same size and may land in the same timestamp tick
+    auto mtime = fs::last_write_time("catalog_test/a.bin");
+    MakeTestFirmware("catalog_test/a.bin", "DM1701", 3);
+    fs::last_write_time("catalog_test/a.bin", mtime + std::chrono::seconds(10));
+
+    fw::FirmwareCatalog cat("catalog_test");
+    assert(cat.Update() == 1);
+    cat.Save();
+
+    auto uv = cat.FindModel("UV3X0");
+    assert(uv.size() == 1 && uv[0]->path == "sub/b.bin" && uv[0]->IsFirmware());
+    assert(uv[0]->segments.size() == 2 && uv[0]->image_size == 0x3000 + 0x1234);
+    assert(cat.FindModel("MD380").empty());
+
+    auto dm = cat.FindModel("DM1701");
+    assert(dm.size() == 1 && dm[0]->path == "a.bin");
+
+    auto a = ReadFile("catalog_test/a.bin");
+    auto by_sha = cat.FindDigest(digest::SHA256::Hash(a.data(), a.size()));
+    assert(by_sha.size() == 1 && by_sha[0]->path == "a.bin");
+
+    auto id = cat.Identify("catalog_test/sub/b.bin");
+    assert(id.size() == 1 && id[0]->path == "sub/b.bin");
+
+    for (const auto &e : cat.GetEntries())
+    {
+        assert(e.IsFirmware() == (e.path != "notes.txt"));
+    }
+
+    //the saved index round trips
+    fw::FirmwareCatalog reload("catalog_test");
+    assert(reload.Update() == 0);
+    assert(reload.FindModel("DM1701").size() == 1);
+}
+
+static auto TestRewriteInPlace() -> void
+{
+    namespace fs = std::filesystem;
+    fs::remove_all("rewrite_test");
+    fs::create_directories("rewrite_test");
+    MakeTestFirmware("rewrite_test/tyt.bin", "MD380", 5);
+    {
+        std::vector<uint8_t> image(0x5000);
+        for (auto x = 0u; x < image.size(); x++)
+        {
+            image[x] = (uint8_t)(x * 7 + (x >> 8));
+        }
+        fw::CSFW cs;
+        cs.SetSegments({{0x10000, ByteView(image)}});
+        cs.Encrypt();
+        cs.Write("rewrite_test/cs.bin");
+    }
+
+    //the payload is a view of the mapped input, writing over the input must not destroy it
+    for (const auto &file : {"rewrite_test/tyt.bin", "rewrite_test/cs.bin"})
+    {
+        auto orig = ReadFile(file);
+        auto h = fw::FirmwareFactory::GetFirmwareFileHandler(file);
+        h->Read(file);
+        h->Write(file);
+        assert(ReadFile(file) == orig);
+        assert(!fs::exists(std::string(file) + ".tmp"));
+
+        h = fw::FirmwareFactory::GetFirmwareFileHandler(file);
+        h->Read(file);
+    }
+}
+
 int main(int argc, char **argv)
 {
     std::vector<uint8_t> t1 = {'a', 'b', 'c', 'd', 'e'};
     std::vector<uint8_t> t2 = {'a', 'b', 'c', 'd', 'e', 'f'};
-    std::vector<uint8_t> t3 = {'a', 'b', 'c', 'd', 'e', 'f', 'g'};
+    std::vector<uint8_t> t3 = {'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h'};
 
     auto t1_i = t1.begin();
     auto t2_i = t2.begin();
     auto t3_i = t3.begin();
 
+    TestXOR();
+
     assert(Fletcher16(t1_i, t1.size()) == 0xC8F0);
     assert(Fletcher16(t2_i, t2.size()) == 0x2057);
     assert(Fletcher16(t3_i, t3.size()) == 0x0627);
+
+    TestChecksum();
+    TestDigest();
+    TestFlashDelta();
+    TestChunking();
+    TestRadioLookup();
+    TestFirmwareImage();
+    TestMalformedHeader();
+    TestBatch();
+    TestElf();
+    TestStore();
+    TestMultiWrap();
+    TestCatalog();
+    TestRewriteInPlace();
 }
\ No newline at end of file
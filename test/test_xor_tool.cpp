@@ -1,38 +1,221 @@
+/**
+ * This file is part of radio_tool.
+ * Copyright (c) 2020 Kieran Harkin <kieran+git@harkin.me>
+ * 
+ * radio_tool is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * radio_tool is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with radio_tool. If not, see <https://www.gnu.org/licenses/>.
+ */
 #include <iostream>
+#include <iomanip>
 #include <vector>
+#include <random>
+#include <cstring>
+#include <cstddef>
+#include <fstream>
+#include <iterator>
 #include <exception>
 
 #include <radio_tool/fw/fw_factory.hpp>
+#include <radio_tool/fw/xor_tool.hpp>
+#include <radio_tool/fw/cipher/md380.hpp>
+#include <radio_tool/fw/cipher/detect.hpp>
 #include <radio_tool/util/flash.hpp>
-#include <xor_tool.hpp>
+#include <radio_tool/util.hpp>
 
 using namespace radio_tool::fw;
 using namespace radio_tool::flash;
 
+constexpr auto address = 0x0800c000u;
+
+/**
+ * Generated image: vector table, random code then erased flash
+ */
+auto MakeImage() -> std::vector<uint8_t>
+{
+    std::vector<uint8_t> data(0x40000, 0xff);
+
+    std::mt19937 rng(1337);
+    for (auto x = 0u; x < 0x18000; x++)
+    {
+        data[x] = rng() & 0xff;
+    }
+
+    std::vector<uint32_t> vt(16 + 82, 0);
+    vt[0] = 0x20020000;
+    for (auto x = 1u; x < vt.size(); x++)
+    {
+        if (x < 7 || x > 13)
+        {
+            vt[x] = address + 0x200 + (x * 4) + 1;
+        }
+    }
+    memcpy(data.data(), vt.data(), vt.size() * sizeof(uint32_t));
+    return data;
+}
+
+/**
+ * Recover the key of a generated image
+ */
+auto TestSynthetic() -> void
+{
+    auto data = MakeImage();
+    radio_tool::ApplyXOR(data, cipher::md380, cipher::md380_length);
+
+    auto key = XORTool::MakeXOR(data, cipher::md380_length);
+    if (key != std::vector<uint8_t>(cipher::md380, cipher::md380 + cipher::md380_length))
+    {
+        throw std::runtime_error("Recovered key does not match");
+    }
+    if (!XORTool::Verify(address, data, key))
+    {
+        throw std::runtime_error("Vector table did not verify");
+    }
+    if (XORTool::Verify(address, data, key, 1))
+    {
+        throw std::runtime_error("Vector table verified with the wrong key offset");
+    }
+}
+
+/**
+ * Every known key must be detected from samples of a generated image
+ */
+auto TestDetect() -> void
+{
+    const auto plain = MakeImage();
+    for (const auto &c : cipher::AllCiphers)
+    {
+        auto data = plain;
+        radio_tool::ApplyXOR(data, c.key, c.length);
+
+        auto best = cipher::CipherDetect::Detect(cipher::CipherDetect::MakeSamples(data.data(), data.size()));
+        if (!best || best->cipher->id != c.id)
+        {
+            throw std::runtime_error(std::string("Failed to detect cipher ") + c.name);
+        }
+    }
+}
+
+/**
+ * A TYT file with a counter magic which is not in tyt::config is read and its key detected
+ */
+auto TestUnknownMagic() -> void
+{
+    auto fw = TYTFW();
+    fw.SetRadioModel("UV3X0");
+    auto image = MakeImage();
+    fw.SetSegments({{address, radio_tool::ByteView(image)}});
+    const auto plain = std::vector<uint8_t>(fw.GetData().begin(), fw.GetData().end());
+    fw.Encrypt();
+    fw.Write("unknown_magic.bin");
+
+    //counter magic is after the magic, model and 4 numbers
+    {
+        std::fstream f("unknown_magic.bin", std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+        f.seekp(offsetof(TYTFirmwareHeader, counter_magic));
+        f.write("\x01\x55", 2);
+    }
+
+    auto h = FirmwareFactory::GetFirmwareFileHandler("unknown_magic.bin");
+    h->Read("unknown_magic.bin");
+    if (h->GetRadioModel() != TYTFW::UnknownRadio || FirmwareFactory::GetFirmwareFileInfo("unknown_magic.bin")->GetRadioModel() != TYTFW::UnknownRadio)
+    {
+        throw std::runtime_error("Unknown counter magic was not reported as unknown");
+    }
+    h->Decrypt();
+    if (!std::equal(plain.begin(), plain.end(), h->GetData().begin(), h->GetData().end()))
+    {
+        throw std::runtime_error("Key for unknown counter magic not detected");
+    }
+}
+
+/**
+ * CS files are read with whichever CS key matches the checksum, even when samples cant tell them apart
+ */
+auto TestCSKey() -> void
+{
+    std::vector<uint8_t> plain(0x20000);
+    std::mt19937 rng(4242);
+    for (auto &b : plain)
+    {
+        b = rng() & 0xff;
+    }
+
+    auto fw = CSFW();
+    fw.SetSegments({{0x10000, radio_tool::ByteView(plain)}});
+    fw.Encrypt();
+    fw.Write("cs_key.bin");
+
+    std::vector<uint8_t> file;
+    {
+        std::ifstream f("cs_key.bin", std::ios_base::binary);
+        file.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    }
+
+    for (const auto &key : {cipher::CipherKey::CS800_0, cipher::CipherKey::CS800_1, cipher::CipherKey::DR5XX0})
+    {
+        //re-encrypt the image and checksum with this key
+        auto enc = file;
+        auto n = enc.size() - sizeof(CS800D_header);
+        cipher::GetCipherInfo(cipher::CipherKey::CS800_0).make(0).Apply(enc.data() + sizeof(CS800D_header), n);
+        cipher::GetCipherInfo(key).make(0).Apply(enc.data() + sizeof(CS800D_header), n);
+        {
+            std::ofstream f("cs_key.bin", std::ios_base::binary);
+            f.write((const char *)enc.data(), enc.size());
+        }
+
+        auto h = FirmwareFactory::GetFirmwareFileHandler("cs_key.bin");
+        h->Read("cs_key.bin");
+        h->Decrypt();
+        if (!std::equal(plain.begin(), plain.end(), h->GetData().begin(), h->GetData().end()))
+        {
+            throw std::runtime_error(std::string("CS file not decrypted with ") + cipher::GetCipherInfo(key).name);
+        }
+    }
+}
+
 int main(int argc, char **argv)
 {
+    if (argc == 1)
+    {
+        TestSynthetic();
+        TestDetect();
+        TestUnknownMagic();
+        TestCSKey();
+        exit(0);
+    }
     if (argc != 2)
     {
-        std::cerr << "Usage: " << argv[0] << " <firmware.bin>" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " [firmware.bin]" << std::endl;
         exit(1);
     }
     const char *file = argv[1];
 
     std::cout << "Testing: " << file << std::endl;
 
-    auto h = FirmwareFactory::GetFirmwareHandler(file);
+    auto h = FirmwareFactory::GetFirmwareFileHandler(file);
     h->Read(file);
 
     std::cout << h->ToString();
 
     //test key
-    auto key = XORTool::MakeXOR(h->GetData());
+    auto key = XORTool::MakeXOR(*h);
+    auto r_offset = 0u;
     for (const auto &region : h->GetDataSegments())
     {
         //Only test segments which are mapped to mcu flash section
         if (FlashUtil::GetSector(STM32F40X, region.address))
         {
-            if (radio_tool::fw::XORTool::Verify(region.address, region.data, key))
+            if (XORTool::Verify(region.address, region.data, key, r_offset))
             {
                 std::cout
                     << "Region @ 0x" << std::setfill('0') << std::setw(8) << std::hex << region.address
@@ -43,6 +226,7 @@ int main(int argc, char **argv)
                 throw std::runtime_error("XOR appears to be wrong");
             }
         }
+        r_offset += region.size;
     }
     exit(0);
-}
\ No newline at end of file
+}